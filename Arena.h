@@ -0,0 +1,472 @@
+/**
+ *  @file Arena.h
+ *  @brief Declaration for arena allocators that hand out many small objects from a few large blocks.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_ARENA_H_
+#define _INCLUDE_ARENA_H_
+
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <stdint.h>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std;
+
+/**
+ *  @brief Constructs objects of a single type inside large blocks of memory it owns.
+ *  @param storedType The type of the objects to construct.
+ *  @detail Blocks double in size from FIRST_BLOCK_SIZE up to MAX_BLOCK_SIZE objects, so the
+ *  number of heap allocations grows only logarithmically with the number of objects until the
+ *  blocks reach their largest size. Destroyed objects leave their slot on a free list which
+ *  create() takes from before it touches fresh memory. Objects never move once constructed.
+ *  @note Destroying the ObjectArena releases its blocks but does not run the destructors of
+ *  objects that are still alive; the owner is expected to destroy() those first.
+ */
+template <typename storedType>
+class ObjectArena
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Parameter-less constructor. No memory is allocated until the first create().
+         */
+        ObjectArena(void) : mBlocks(NULL), mFree(NULL), mUsed(0), mCapacity(0), mLive(0)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Releases every block.
+         */
+        ~ObjectArena(void)
+        {
+            while (mBlocks)
+            {
+                Block *next = mBlocks->pNext;
+                delete[] mBlocks->slots;
+                delete mBlocks;
+                mBlocks = next;
+            }
+        }
+
+        ObjectArena(const ObjectArena<storedType> &) = delete;
+        ObjectArena<storedType>& operator =(const ObjectArena<storedType> &) = delete;
+
+        /**
+         *  @brief Constructs a new object from arguments.
+         *  @param arguments The arguments to pass to the constructor of storedType.
+         *  @return A pointer to the new object. It stays valid until it is passed to destroy().
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for a new block. Anything thrown by the constructor of storedType is
+         *  passed on, and the slot is returned to the arena.
+         */
+        template <typename... argumentTypes>
+        storedType *create(argumentTypes&&... arguments)
+        {
+            Slot *slot = takeSlot();
+
+            try
+            {
+                storedType *result = new (slot->storage) storedType(std::forward<argumentTypes>(arguments)...);
+                ++mLive;
+                return result;
+            }
+            catch (...)
+            {
+                slot->pNext = mFree;
+                mFree = slot;
+                throw;
+            }
+        }
+
+        /**
+         *  @brief Destroys an object made by create() and keeps its memory for reuse.
+         *  @param object The object to destroy. It must have come from this ObjectArena.
+         */
+        void destroy(storedType *object)
+        {
+            object->~storedType();
+
+            Slot *slot = reinterpret_cast<Slot *>(object);
+            slot->pNext = mFree;
+            mFree = slot;
+            --mLive;
+        }
+
+        /**
+         *  @brief Returns the number of objects currently alive in this ObjectArena.
+         *  @return The number of objects created and not yet destroyed.
+         */
+        size_t getSize(void) const
+        {
+            return mLive;
+        }
+
+        /**
+         *  @brief Returns the number of objects the blocks allocated so far can hold.
+         *  @return The total capacity of every block.
+         */
+        size_t getCapacity(void) const
+        {
+            return mCapacity;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  Storage for one object, or a link in the free list while it holds none.
+         */
+        union Slot
+        {
+            //! The next free Slot. NULL if this is the last.
+            Slot *pNext;
+            //! The object itself.
+            alignas(storedType) unsigned char storage[sizeof(storedType)];
+        };
+
+        /**
+         *  One allocation holding many Slots.
+         */
+        struct Block
+        {
+            //! The Block allocated before this one. NULL if this is the first.
+            Block *pNext;
+            //! The Slots of this Block.
+            Slot *slots;
+            //! The number of Slots in this Block.
+            size_t size;
+        };
+
+        //! The number of objects the first Block holds.
+        static constexpr size_t FIRST_BLOCK_SIZE = 16;
+        //! The most objects a single Block holds.
+        static constexpr size_t MAX_BLOCK_SIZE = 4096;
+
+        //! The newest Block, which fresh Slots are taken from. NULL before the first create().
+        Block *mBlocks;
+        //! The first Slot of the free list. NULL if it is empty.
+        Slot *mFree;
+        //! The number of Slots of the newest Block handed out so far.
+        size_t mUsed;
+        //! The number of Slots in every Block.
+        size_t mCapacity;
+        //! The number of objects alive.
+        size_t mLive;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Returns an unused Slot, preferring the free list over fresh memory.
+         *  @return The Slot.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for a new Block.
+         */
+        Slot *takeSlot(void)
+        {
+            if (mFree)
+            {
+                Slot *result = mFree;
+                mFree = mFree->pNext;
+                return result;
+            }
+
+            if (!mBlocks || mUsed == mBlocks->size)
+            {
+                size_t size = mBlocks ? mBlocks->size << 1 : FIRST_BLOCK_SIZE;
+                if (size > MAX_BLOCK_SIZE)
+                    size = MAX_BLOCK_SIZE;
+
+                Block *block = new Block;
+                try
+                {
+                    block->slots = new Slot[size];
+                }
+                catch (...)
+                {
+                    delete block;
+                    throw;
+                }
+
+                block->size = size;
+                block->pNext = mBlocks;
+                mBlocks = block;
+                mCapacity += size;
+                mUsed = 0;
+            }
+
+            return &mBlocks->slots[mUsed++];
+        }
+};
+
+/**
+ *  @brief Packs strings back to back into one growing buffer and refers to them by offset.
+ *  @detail Every string is stored as a Record header holding its hash and length, followed by
+ *  its characters and a terminating NUL, padded so the next header stays aligned. Adding a
+ *  string is a bump of the end offset, with the buffer doubling when it runs out, so there is no
+ *  per string allocation and no fragmentation. Offsets stay valid across growth even though the
+ *  buffer moves, and since the buffer holds no pointers it can be written out and read back as
+ *  is. Released strings are only flagged dead; their bytes are counted by getDeadBytes() so the
+ *  owner can decide when to copy the live strings into a fresh StringArena.
+ */
+class StringArena
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of bytes to reserve up front.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the buffer.
+         */
+        StringArena(const size_t &initialCapacity = 0) : mData(NULL), mSize(0), mCapacity(0), mDeadBytes(0)
+        {
+            if (initialCapacity)
+                reserve(initialCapacity);
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~StringArena(void)
+        {
+            free(mData);
+        }
+
+        StringArena(const StringArena &) = delete;
+        StringArena& operator =(const StringArena &) = delete;
+
+        /**
+         *  @brief Copies a string to the end of the buffer.
+         *  @param value The string to copy.
+         *  @param hash The hash to keep alongside the string.
+         *  @return The offset of the new string.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the buffer.
+         *  @throw length_error Thrown when value is too long to be described by a Record.
+         */
+        size_t add(string_view value, const uint32_t &hash)
+        {
+            if (value.size() >= DEAD)
+                throw length_error("StringArena::add");
+
+            size_t offset = mSize;
+            size_t size = recordSize(value.size());
+
+            if (mSize + size > mCapacity)
+                reserve(mCapacity * 2 > mSize + size ? mCapacity * 2 : mSize + size);
+
+            Record record;
+            record.hash = hash;
+            record.length = static_cast<uint32_t>(value.size());
+
+            memcpy(mData + offset, &record, sizeof(Record));
+            memcpy(mData + offset + sizeof(Record), value.data(), value.size());
+            memset(mData + offset + sizeof(Record) + value.size(), 0, size - sizeof(Record) - value.size());
+
+            mSize += size;
+            return offset;
+        }
+
+        /**
+         *  @brief Returns a string stored in this StringArena.
+         *  @param offset The offset returned by add().
+         *  @return A view of the string. It is invalidated by the next add().
+         */
+        string_view get(const size_t &offset) const
+        {
+            Record record = recordAt(offset);
+            return string_view(mData + offset + sizeof(Record), record.length & ~DEAD);
+        }
+
+        /**
+         *  @brief Reads a string out of a buffer previously copied from getData(), such as one
+         *  mapped in from a file.
+         *  @param data A pointer to the buffer.
+         *  @param size The number of bytes in the buffer.
+         *  @param offset The offset of the string, as returned by add().
+         *  @param result Assigned a view of the string inside data.
+         *  @return A boolean representing whether or not the string lies within the buffer.
+         */
+        static bool view(const char *data, const size_t &size, const size_t &offset, string_view &result)
+        {
+            if (offset > size || size - offset < sizeof(Record))
+                return false;
+
+            Record record;
+            memcpy(&record, data + offset, sizeof(Record));
+
+            uint32_t length = record.length & ~DEAD;
+            if (size - offset - sizeof(Record) < length)
+                return false;
+
+            result = string_view(data + offset + sizeof(Record), length);
+            return true;
+        }
+
+        /**
+         *  @brief Returns the hash kept alongside a string.
+         *  @param offset The offset returned by add().
+         *  @return The hash passed to add().
+         */
+        uint32_t getHash(const size_t &offset) const
+        {
+            return recordAt(offset).hash;
+        }
+
+        /**
+         *  @brief Flags a string as no longer used. Its bytes stay in place.
+         *  @param offset The offset returned by add().
+         */
+        void release(const size_t &offset)
+        {
+            Record record = recordAt(offset);
+
+            mDeadBytes += recordSize(record.length);
+            record.length |= DEAD;
+            memcpy(mData + offset, &record, sizeof(Record));
+        }
+
+        /**
+         *  @brief Calls functor with every string that has not been released, in the order they
+         *  were added.
+         *  @param functor A callable accepting the offset, a string_view and the hash of each string.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t offset = 0; offset < mSize; )
+            {
+                Record record = recordAt(offset);
+                uint32_t length = record.length & ~DEAD;
+
+                if (!(record.length & DEAD))
+                    functor(offset, string_view(mData + offset + sizeof(Record), length), record.hash);
+
+                offset += recordSize(length);
+            }
+        }
+
+        /**
+         *  @brief Makes sure the buffer can hold at least capacity bytes without growing.
+         *  @param capacity The number of bytes to make room for.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the buffer.
+         */
+        void reserve(const size_t &capacity)
+        {
+            if (capacity <= mCapacity)
+                return;
+
+            char *data = static_cast<char *>(realloc(mData, capacity));
+            if (!data)
+                throw bad_alloc();
+
+            mData = data;
+            mCapacity = capacity;
+        }
+
+        /**
+         *  @brief Exchanges the contents of two StringArenas.
+         *  @param other The StringArena to swap with.
+         */
+        void swap(StringArena &other)
+        {
+            std::swap(mData, other.mData);
+            std::swap(mSize, other.mSize);
+            std::swap(mCapacity, other.mCapacity);
+            std::swap(mDeadBytes, other.mDeadBytes);
+        }
+
+        /**
+         *  @brief Returns the buffer, which may be written out as is.
+         *  @return A pointer to the first byte of the buffer, or NULL if nothing was ever added.
+         */
+        const char *getData(void) const
+        {
+            return mData;
+        }
+
+        /**
+         *  @brief Returns the number of bytes in use, dead strings included.
+         *  @return The end offset of the last string.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns the number of bytes allocated for the buffer.
+         *  @return The capacity of the buffer.
+         */
+        size_t getCapacity(void) const
+        {
+            return mCapacity;
+        }
+
+        /**
+         *  @brief Returns the number of bytes held by released strings.
+         *  @return The bytes that a copy into a fresh StringArena would save.
+         */
+        size_t getDeadBytes(void) const
+        {
+            return mDeadBytes;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  The header in front of every string.
+         */
+        struct Record
+        {
+            //! The hash passed to add().
+            uint32_t hash;
+            //! The number of characters, with DEAD set once the string is released.
+            uint32_t length;
+        };
+
+        //! Set in Record::length once a string has been released.
+        static constexpr uint32_t DEAD = 0x80000000U;
+
+        //! The buffer. NULL until the first add() or reserve().
+        char *mData;
+        //! The number of bytes in use.
+        size_t mSize;
+        //! The number of bytes allocated.
+        size_t mCapacity;
+        //! The number of bytes held by released strings.
+        size_t mDeadBytes;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Returns the number of bytes a string of some length takes up, header included.
+         *  @param length The number of characters in the string.
+         *  @return The size of the Record, the characters and the NUL, rounded up to keep the
+         *  next Record aligned.
+         */
+        static size_t recordSize(const size_t &length)
+        {
+            size_t size = sizeof(Record) + length + 1;
+            return (size + alignof(Record) - 1) & ~(alignof(Record) - 1);
+        }
+
+        /**
+         *  @brief Reads the header of a string.
+         *  @param offset The offset of the string.
+         *  @return A copy of the Record.
+         */
+        Record recordAt(const size_t &offset) const
+        {
+            Record result;
+            memcpy(&result, mData + offset, sizeof(Record));
+            return result;
+        }
+};
+#endif // _INCLUDE_ARENA_H_
@@ -0,0 +1,198 @@
+/**
+ *  @file AsyncQueue.h
+ *  @brief Declaration for a generically typed Queue whose pop() may be awaited
+ *  from a coroutine.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_ASYNCQUEUE_H_
+#define _INCLUDE_ASYNCQUEUE_H_
+
+#include <coroutine>
+
+#include "Queue.h"
+#include "Executor.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed Queue for coroutines. Awaiting pop() on an empty AsyncQueue
+ *  suspends the calling coroutine instead of blocking a thread; a later add() hands its
+ *  value directly to the longest waiting coroutine and schedules it on the Executor.
+ *  @param storedType The type to store in our AsyncQueue.
+ *  @note Waiting coroutines are linked through their own awaiter objects, which live in
+ *  the coroutine frame, so waiting costs no allocation no matter how many consumers there are.
+ */
+template <typename storedType>
+class AsyncQueue
+{
+    // Public Members
+    public:
+        /**
+         *  @brief The awaitable returned by pop(). While suspended it doubles as the node
+         *  of the AsyncQueue's waiter list.
+         */
+        class PopAwaiter
+        {
+            // Public Methods
+            public:
+                /**
+                 *  @brief Constructor accepting the AsyncQueue to pop from.
+                 *  @param queue The AsyncQueue to pop from.
+                 */
+                explicit PopAwaiter(AsyncQueue<storedType> &queue) : mQueue(queue), mNext(NULL)
+                {
+
+                }
+
+                /**
+                 *  @brief Returns whether or not a value can be taken without suspending.
+                 *  @return A boolean representing whether or not the AsyncQueue holds a value.
+                 */
+                bool await_ready(void) const
+                {
+                    return !mQueue.mValues.isEmpty();
+                }
+
+                /**
+                 *  @brief Appends the suspending coroutine to the waiter list.
+                 *  @param handle The coroutine being suspended.
+                 */
+                void await_suspend(coroutine_handle<> handle)
+                {
+                    mHandle = handle;
+                    mQueue.enqueueWaiter(this);
+                }
+
+                /**
+                 *  @brief Produces the popped value when the coroutine continues.
+                 *  @return The value at the front of the AsyncQueue, or the value that was
+                 *  handed to this awaiter by add().
+                 */
+                storedType await_resume(void)
+                {
+                    if (mHandle)
+                        return mValue;
+
+                    return mQueue.mValues.pop();
+                }
+
+            // Private Members
+            private:
+                friend class AsyncQueue<storedType>;
+
+                //! The AsyncQueue being popped from.
+                AsyncQueue<storedType> &mQueue;
+                //! The suspended coroutine. NULL when the value was available immediately.
+                coroutine_handle<> mHandle;
+                //! The value handed over by add() while suspended.
+                storedType mValue;
+                //! The next waiter in line. NULL if this is the last waiter.
+                PopAwaiter *mNext;
+        };
+
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the Executor that resumes waiting consumers.
+         *  @param executor The Executor to schedule resumed coroutines on.
+         */
+        explicit AsyncQueue(Executor &executor) : mExecutor(executor), mWaitHead(NULL), mWaitTail(NULL)
+        {
+
+        }
+
+        /**
+         *  @brief Adds a value to this AsyncQueue. If a coroutine is waiting, the value is
+         *  handed to it directly and it is scheduled on the Executor.
+         *  @param value The value to add to the end of the AsyncQueue.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Link.
+         */
+        void add(storedType value)
+        {
+            if (!mWaitHead)
+            {
+                mValues.add(value);
+                return;
+            }
+
+            PopAwaiter *waiter = mWaitHead;
+
+            mWaitHead = waiter->mNext;
+            if (!mWaitHead)
+                mWaitTail = NULL;
+
+            waiter->mValue = value;
+            mExecutor.schedule(waiter->mHandle);
+        }
+
+        /**
+         *  @brief Pops a value from the front of this AsyncQueue.
+         *  @return An awaitable producing the value. The awaiting coroutine is suspended
+         *  while the AsyncQueue is empty.
+         */
+        PopAwaiter pop(void)
+        {
+            return PopAwaiter(*this);
+        }
+
+        /**
+         *  @brief Returns whether or not this AsyncQueue holds any values.
+         *  @return A boolean representing whether or not this AsyncQueue is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mValues.isEmpty();
+        }
+
+        /**
+         *  @brief Returns whether or not any coroutine is suspended in pop().
+         *  @return A boolean representing whether or not there are waiting consumers.
+         */
+        bool hasWaiters(void) const
+        {
+            return mWaitHead != NULL;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put an AsyncQueue into a stream.
+         *  @param stream The std::ostream to write into.
+         *  @param input The AsyncQueue to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const AsyncQueue<storedType> &input)
+        {
+            return stream << input.mValues;
+        }
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Appends a suspended awaiter to the end of the waiter list.
+         *  @param waiter The awaiter to append.
+         */
+        void enqueueWaiter(PopAwaiter *waiter)
+        {
+            if (!mWaitTail)
+            {
+                mWaitHead = mWaitTail = waiter;
+                return;
+            }
+
+            mWaitTail->mNext = waiter;
+            mWaitTail = waiter;
+        }
+
+    // Private Members
+    private:
+        //! The Executor waiting coroutines are resumed on.
+        Executor &mExecutor;
+        //! Values added while nobody was waiting.
+        Queue<storedType> mValues;
+        //! The longest waiting consumer. NULL if nobody is waiting.
+        PopAwaiter *mWaitHead;
+        //! The most recent waiting consumer. NULL if nobody is waiting.
+        PopAwaiter *mWaitTail;
+};
+#endif // _INCLUDE_ASYNCQUEUE_H_
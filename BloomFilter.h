@@ -0,0 +1,284 @@
+/**
+ *  @file BloomFilter.h
+ *  @brief Declaration for a blocked Bloom filter over 64 bit key hashes.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_BLOOMFILTER_H_
+#define _INCLUDE_BLOOMFILTER_H_
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ *  @brief A set of hashes that answers "definitely absent" or "possibly present".
+ *  @detail The filter is an array of cache line sized Blocks of 512 bits. A hash selects one
+ *  Block and sets or tests all of its bits inside it, so a lookup touches one cache line no
+ *  matter how many bits it checks, where a classic Bloom filter touches one per bit. Confining
+ *  the bits to a Block makes the false positive rate somewhat worse than a classic filter of the
+ *  same size, so the constructor sizes the filter from a model of a blocked filter rather than
+ *  the usual formula for a classic one.
+ *  @note Elements cannot be removed; a filter that has seen many removals is rebuilt instead.
+ */
+class BloomFilter
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the number of hashes to size for and the target false
+         *  positive rate.
+         *  @param expectedCount The number of hashes the filter will hold. Adding more works, but
+         *  the false positive rate climbs past falsePositiveRate.
+         *  @param falsePositiveRate The fraction of absent hashes that may be reported as present
+         *  once expectedCount hashes have been added.
+         *  @throw invalid_argument Thrown when falsePositiveRate is not between 0 and 1.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Blocks.
+         */
+        BloomFilter(const size_t &expectedCount, const double &falsePositiveRate = 0.01)
+        {
+            if (!(falsePositiveRate > 0.0 && falsePositiveRate < 1.0))
+                throw invalid_argument("BloomFilter false positive rate must be between 0 and 1");
+
+            // Search for the fewest bits per key, and the best number of bits per hash for it, that reach the rate
+            double bitsPerKey = MIN_BITS_PER_KEY;
+            mHashCount = 1;
+
+            for (; bitsPerKey < MAX_BITS_PER_KEY; bitsPerKey += BITS_PER_KEY_STEP)
+            {
+                double best = 1.0;
+
+                // The optimum number of bits per hash is near ln(2) times the bits per key
+                uint32_t center = static_cast<uint32_t>(bitsPerKey * 0.693);
+                for (uint32_t hashCount = center ? center : 1; hashCount <= center + 1 && hashCount <= MAX_HASH_COUNT; hashCount++)
+                {
+                    double rate = estimateFalsePositiveRate(bitsPerKey, hashCount);
+                    if (rate < best)
+                    {
+                        best = rate;
+                        mHashCount = hashCount;
+                    }
+                }
+
+                if (best <= falsePositiveRate)
+                    break;
+            }
+
+            double bitCount = ceil(bitsPerKey * (expectedCount ? expectedCount : 1));
+
+            mExpectedCount = expectedCount;
+            mBlockCount = static_cast<size_t>(ceil(bitCount / BLOCK_BITS));
+            mBlocks = new Block[mBlockCount]();
+            mSize = 0;
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~BloomFilter(void)
+        {
+            delete[] mBlocks;
+        }
+
+        BloomFilter(const BloomFilter &) = delete;
+        BloomFilter& operator =(const BloomFilter &) = delete;
+
+        /**
+         *  @brief Adds a hash to the filter.
+         *  @param hash The 64 bit hash of the key. Any hash function will do, since the filter
+         *  mixes it again.
+         */
+        void add(const uint64_t &hash)
+        {
+            uint64_t mixed = mix(hash);
+            Block &block = mBlocks[blockOf(mixed)];
+
+            uint32_t state = static_cast<uint32_t>(mixed);
+
+            for (uint32_t iteration = 0; iteration < mHashCount; iteration++)
+            {
+                uint32_t bit = nextBit(state);
+                block.words[bit >> 6] |= 1ULL << (bit & 63);
+            }
+
+            ++mSize;
+        }
+
+        /**
+         *  @brief Tests whether a hash may have been added to the filter.
+         *  @param hash The 64 bit hash of the key, produced the same way as for add().
+         *  @return A boolean representing whether or not the hash may be present.
+         *  @retval false Returned if the hash was definitely never added.
+         */
+        bool mayContain(const uint64_t &hash) const
+        {
+            uint64_t mixed = mix(hash);
+            const Block &block = mBlocks[blockOf(mixed)];
+
+            uint32_t state = static_cast<uint32_t>(mixed);
+
+            for (uint32_t iteration = 0; iteration < mHashCount; iteration++)
+            {
+                uint32_t bit = nextBit(state);
+                if (!(block.words[bit >> 6] & (1ULL << (bit & 63))))
+                    return false;
+            }
+
+            return true;
+        }
+
+        /**
+         *  @brief Removes every hash from the filter.
+         */
+        void clear(void)
+        {
+            memset(static_cast<void *>(mBlocks), 0, mBlockCount * sizeof(Block));
+            mSize = 0;
+        }
+
+        /**
+         *  @brief Returns the number of add() calls since construction or the last clear().
+         *  @return The number of hashes added, counting repeats.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns the number of hashes the filter was sized for.
+         *  @return The expectedCount passed to the constructor.
+         */
+        size_t getExpectedCount(void) const
+        {
+            return mExpectedCount;
+        }
+
+        /**
+         *  @brief Returns the number of bits set or tested per hash.
+         *  @return The number of bits per hash.
+         */
+        uint32_t getHashCount(void) const
+        {
+            return mHashCount;
+        }
+
+        /**
+         *  @brief Returns the memory taken by the bits of the filter.
+         *  @return The size of the Block array in bytes.
+         */
+        size_t getByteSize(void) const
+        {
+            return mBlockCount * sizeof(Block);
+        }
+
+    // Private Members
+    private:
+        //! The base two logarithm of the number of bits in a Block.
+        static constexpr uint32_t BLOCK_SHIFT = 9;
+        //! The number of bits in a Block.
+        static constexpr uint32_t BLOCK_BITS = 1U << BLOCK_SHIFT;
+        //! The number of 64 bit words in a Block.
+        static constexpr uint32_t BLOCK_WORDS = BLOCK_BITS / 64;
+        //! The most bits set per hash.
+        static constexpr uint32_t MAX_HASH_COUNT = 16;
+        //! The fewest bits per key the constructor considers.
+        static constexpr double MIN_BITS_PER_KEY = 2.0;
+        //! The most bits per key the constructor considers, which is what rates too small to reach get.
+        static constexpr double MAX_BITS_PER_KEY = 64.0;
+        //! The granularity of the bits per key the constructor considers.
+        static constexpr double BITS_PER_KEY_STEP = 0.25;
+
+        /**
+         *  A cache line of bits.
+         */
+        struct alignas(64) Block
+        {
+            //! The bits.
+            uint64_t words[BLOCK_WORDS];
+        };
+
+        //! The Block array.
+        Block *mBlocks;
+        //! The number of Blocks.
+        size_t mBlockCount;
+        //! The number of bits set per hash.
+        uint32_t mHashCount;
+        //! The number of hashes the filter was sized for.
+        size_t mExpectedCount;
+        //! The number of add() calls since the last clear().
+        size_t mSize;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Estimates the false positive rate of a blocked filter. The number of keys that
+         *  land in a Block is Poisson distributed, and the overfull Blocks contribute far more
+         *  false positives than the underfull ones save, which is why a blocked filter needs more
+         *  bits per key than a classic one and more so the lower the rate.
+         *  @param bitsPerKey The number of bits in the filter per key it holds.
+         *  @param hashCount The number of bits set per key, which may coincide.
+         *  @return The expected fraction of absent hashes reported as present.
+         */
+        static double estimateFalsePositiveRate(const double &bitsPerKey, const uint32_t &hashCount)
+        {
+            double mean = BLOCK_BITS / bitsPerKey;
+            double probability = exp(-mean);
+            double clearPerKey = pow(1.0 - 1.0 / BLOCK_BITS, static_cast<double>(hashCount));
+            double result = 0.0;
+
+            // Sums the rate of a Block holding count keys, weighted by the chance that it does
+            size_t limit = static_cast<size_t>(mean + 12.0 * sqrt(mean) + 12.0);
+            for (size_t count = 0; count <= limit; count++)
+            {
+                result += probability * pow(1.0 - pow(clearPerKey, static_cast<double>(count)), hashCount);
+                probability *= mean / (count + 1);
+            }
+
+            return result;
+        }
+
+        /**
+         *  @brief Spreads every bit of a hash over all 64, so that hashes which only differ in a
+         *  few low bits, as FNV-1a produces for similar keys, still land in different Blocks.
+         *  @param hash The hash to mix.
+         *  @return The mixed hash.
+         */
+        static uint64_t mix(uint64_t hash)
+        {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB9FE1A85EC53ULL;
+            return hash ^ (hash >> 33);
+        }
+
+        /**
+         *  @brief Steps a multiplicative sequence seeded from the low half of a mixed hash and
+         *  returns a bit position within a Block from the top bits of the new state, which are
+         *  the best mixed ones.
+         *  @param state The sequence state, which is advanced.
+         *  @return A bit position from 0 to BLOCK_BITS - 1.
+         */
+        static uint32_t nextBit(uint32_t &state)
+        {
+            state *= 0x9E3779B9U;
+            return state >> (32 - BLOCK_SHIFT);
+        }
+
+        /**
+         *  @brief Selects the Block for a mixed hash from its high bits. The bit positions within
+         *  the Block come from the low 32 bits, so the two are independent.
+         *  @param mixed The mixed hash.
+         *  @return The index of the Block.
+         */
+        size_t blockOf(const uint64_t &mixed) const
+        {
+            return static_cast<size_t>(((mixed >> 32) * mBlockCount) >> 32);
+        }
+};
+#endif // _INCLUDE_BLOOMFILTER_H_
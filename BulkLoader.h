@@ -0,0 +1,451 @@
+/**
+ *  @file BulkLoader.h
+ *  @brief Declaration for a loader that parses a tab separated dictionary file on every core
+ *  and fills HashTables from it.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_BULKLOADER_H_
+#define _INCLUDE_BULKLOADER_H_
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+#include <exception>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "HashTable.h"
+#include "ConcurrentHashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief Loads a file with one key, a tab and a value per line and feeds the pairs into
+ *  HashTables without any table growing along the way.
+ *  @detail open() maps the file and splits it into one chunk per thread at line boundaries.
+ *  Every thread parses and hashes its own chunk, counting how many of its entries fall into each
+ *  partition, where the partition is picked by the high bits of the hash just like the shards of
+ *  a ConcurrentHashTable. The counts give every thread its own write position in each partition,
+ *  so the threads then scatter their entries into one partitioned array without any locking.
+ *  Once the count of entries is known, loadInto() presizes the target and inserts with the hashes
+ *  computed while parsing; a ConcurrentHashTable is filled by all threads at once, each owning
+ *  whole partitions, and so whole shards when the partition and shard counts match.
+ *
+ *  Entries refer to the mapped file, which stays mapped for as long as the BulkLoader lives, so
+ *  the tables filled from it point at Entries instead of copies of the values.
+ */
+class BulkLoader
+{
+    // Public Members
+    public:
+        /**
+         *  @brief One parsed line: a key and its value, both viewing the mapped file.
+         */
+        struct Entry
+        {
+            //! Returns the key.
+            string_view getKey(void) const
+            {
+                return string_view(key, keyLength);
+            }
+
+            //! Returns the value.
+            string_view getValue(void) const
+            {
+                return string_view(value, valueLength);
+            }
+
+            //! Writes the value into a stream.
+            friend ostream& operator <<(ostream &stream, const Entry &entry)
+            {
+                stream << entry.getValue();
+                return stream;
+            }
+
+            //! The first character of the key.
+            const char *key;
+            //! The first character of the value.
+            const char *value;
+            //! The number of characters in the key.
+            uint32_t keyLength;
+            //! The number of characters in the value.
+            uint32_t valueLength;
+            //! The hash of the key as produced by HashTable::hashKey().
+            uint32_t hash;
+        };
+
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the number of threads to use.
+         *  @param threadCount The number of threads to parse and insert with. Zero picks one per
+         *  hardware thread.
+         */
+        BulkLoader(const size_t &threadCount = 0) : mThreadCount(threadCount), mMapping(NULL), mMappingSize(0),
+        mPartitionBits(0), mSkipped(0)
+        {
+            if (!mThreadCount)
+                mThreadCount = thread::hardware_concurrency();
+
+            if (!mThreadCount)
+                mThreadCount = 1;
+        }
+
+        /**
+         *  @brief Standard destructor. Unmaps the file, which invalidates every Entry.
+         */
+        ~BulkLoader(void)
+        {
+            close();
+        }
+
+        BulkLoader(const BulkLoader &) = delete;
+        BulkLoader& operator =(const BulkLoader &) = delete;
+
+        /**
+         *  @brief Maps, parses and partitions a file, replacing whatever was loaded before.
+         *  @param path The path of the file. Each line holds a key, a tab and a value; lines
+         *  without a tab or with an empty key are skipped.
+         *  @param partitionCount The number of partitions to sort the entries into. It is
+         *  rounded up to a power of two. Matching the shard count of a ConcurrentHashTable to be
+         *  filled lets every thread insert into shards no other thread touches.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if the file could not be opened or mapped.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the entries.
+         */
+        bool open(const string &path, const size_t &partitionCount = 64)
+        {
+            close();
+
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0)
+                return false;
+
+            struct stat status;
+            if (fstat(descriptor, &status))
+            {
+                ::close(descriptor);
+                return false;
+            }
+
+            mMappingSize = status.st_size;
+            if (mMappingSize)
+            {
+                mMapping = mmap(NULL, mMappingSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (mMapping == MAP_FAILED)
+                {
+                    mMapping = NULL;
+                    mMappingSize = 0;
+                    ::close(descriptor);
+                    return false;
+                }
+
+                madvise(mMapping, mMappingSize, MADV_SEQUENTIAL);
+            }
+
+            ::close(descriptor);
+
+            mPartitionBits = 0;
+            while ((static_cast<size_t>(1) << mPartitionBits) < partitionCount && mPartitionBits < MAX_PARTITION_BITS)
+                ++mPartitionBits;
+
+            partition();
+            return true;
+        }
+
+        /**
+         *  @brief Unmaps the file and forgets every Entry.
+         */
+        void close(void)
+        {
+            if (mMapping)
+                munmap(mMapping, mMappingSize);
+
+            mMapping = NULL;
+            mMappingSize = 0;
+            mSkipped = 0;
+            mEntries.clear();
+            mPartitionStarts.clear();
+        }
+
+        /**
+         *  @brief Inserts every Entry into a HashTable, after growing it to fit them all.
+         *  @param table The table to fill. Keys already in it are kept unless a line replaces them.
+         *  @note Where a key appears on several lines, the last line wins.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the table.
+         */
+        void loadInto(HashTable<Entry> &table)
+        {
+            table.reserve(table.getSize() + mEntries.size());
+
+            for (size_t index = 0; index < mEntries.size(); index++)
+                table.addHashed(mEntries[index].getKey(), &mEntries[index], mEntries[index].hash);
+        }
+
+        /**
+         *  @brief Inserts every Entry into a ConcurrentHashTable from all threads at once, after
+         *  growing it to fit them all.
+         *  @param table The table to fill. Keys already in it are kept unless a line replaces them.
+         *  @note Where a key appears on several lines, the last line wins.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the table.
+         */
+        void loadInto(ConcurrentHashTable<Entry> &table)
+        {
+            table.reserve(table.getSize() + mEntries.size());
+
+            // Whole partitions go to one thread, so a key's lines are inserted in order
+            runThreads([this, &table](const size_t &threadIndex)
+            {
+                for (size_t partition = threadIndex; partition < getPartitionCount(); partition += mThreadCount)
+                    for (size_t index = mPartitionStarts[partition]; index < mPartitionStarts[partition + 1]; index++)
+                        table.addHashed(mEntries[index].getKey(), &mEntries[index], mEntries[index].hash);
+            });
+        }
+
+        /**
+         *  @brief Calls functor with every Entry, partition by partition and in file order within
+         *  each partition.
+         *  @param functor A callable accepting an Entry &.
+         */
+        template <typename functorType>
+        void forEach(functorType functor)
+        {
+            for (size_t index = 0; index < mEntries.size(); index++)
+                functor(mEntries[index]);
+        }
+
+        /**
+         *  @brief Returns the number of Entries parsed, counting repeated keys every time.
+         *  @return The number of lines that held an entry.
+         */
+        size_t getSize(void) const
+        {
+            return mEntries.size();
+        }
+
+        /**
+         *  @brief Returns the number of non empty lines that were skipped for lacking a key.
+         *  @return The number of skipped lines.
+         */
+        size_t getSkipped(void) const
+        {
+            return mSkipped;
+        }
+
+        /**
+         *  @brief Returns the number of partitions the Entries are sorted into.
+         *  @return The partition count, which is a power of two.
+         */
+        size_t getPartitionCount(void) const
+        {
+            return static_cast<size_t>(1) << mPartitionBits;
+        }
+
+        /**
+         *  @brief Returns the number of threads used.
+         *  @return The thread count.
+         */
+        size_t getThreadCount(void) const
+        {
+            return mThreadCount;
+        }
+
+    // Private Members
+    private:
+        //! The most hash bits used to pick a partition.
+        static constexpr size_t MAX_PARTITION_BITS = 16;
+
+        //! The number of threads to use.
+        size_t mThreadCount;
+        //! The start of the mapping. NULL if nothing is mapped.
+        void *mMapping;
+        //! The number of bytes mapped.
+        size_t mMappingSize;
+        //! The number of high hash bits that select a partition.
+        size_t mPartitionBits;
+        //! The number of non empty lines skipped for lacking a key.
+        size_t mSkipped;
+        //! Every Entry, grouped by partition.
+        vector<Entry> mEntries;
+        //! The index in mEntries where each partition starts, plus the total at the end.
+        vector<size_t> mPartitionStarts;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Calls work on mThreadCount threads, passing each its index, and waits for all of
+         *  them. The last index runs on the calling thread.
+         *  @param work A callable accepting a const size_t &.
+         *  @throw Anything thrown by work, rethrown on the calling thread once every thread is done.
+         */
+        template <typename functorType>
+        void runThreads(functorType work)
+        {
+            vector<thread> threads;
+            vector<exception_ptr> failures(mThreadCount);
+
+            auto guarded = [&work, &failures](const size_t &threadIndex)
+            {
+                try
+                {
+                    work(threadIndex);
+                }
+                catch (...)
+                {
+                    failures[threadIndex] = current_exception();
+                }
+            };
+
+            for (size_t threadIndex = 0; threadIndex + 1 < mThreadCount; threadIndex++)
+                threads.push_back(thread(guarded, threadIndex));
+
+            guarded(mThreadCount - 1);
+
+            for (size_t threadIndex = 0; threadIndex < threads.size(); threadIndex++)
+                threads[threadIndex].join();
+
+            for (size_t threadIndex = 0; threadIndex < mThreadCount; threadIndex++)
+                if (failures[threadIndex])
+                    rethrow_exception(failures[threadIndex]);
+        }
+
+        /**
+         *  @brief Parses the lines of one chunk of the file.
+         *  @param begin The first character of the chunk, which starts a line.
+         *  @param end One past the last character of the chunk, which ends a line.
+         *  @param entries Receives the parsed Entries in file order.
+         *  @param partitionSizes Counts the Entries per partition.
+         *  @return The number of non empty lines skipped for lacking a key.
+         */
+        size_t parse(const char *begin, const char *end, vector<Entry> &entries, vector<size_t> &partitionSizes) const
+        {
+            size_t skipped = 0;
+
+            while (begin < end)
+            {
+                size_t remaining = end - begin;
+                const char *newline = static_cast<const char *>(memchr(begin, '\n', remaining));
+
+                size_t length = newline ? static_cast<size_t>(newline - begin) : remaining;
+                const char *next = begin + (newline ? length + 1 : length);
+
+                if (length && begin[length - 1] == '\r')
+                    --length;
+
+                const char *tab = static_cast<const char *>(memchr(begin, '\t', length));
+                if (tab && tab > begin)
+                {
+                    Entry entry;
+                    entry.key = begin;
+                    entry.keyLength = static_cast<uint32_t>(tab - begin);
+                    entry.value = tab + 1;
+                    entry.valueLength = static_cast<uint32_t>(length - entry.keyLength - 1);
+                    entry.hash = HashTable<Entry>::hashKey(entry.key, entry.keyLength);
+
+                    entries.push_back(entry);
+                    ++partitionSizes[partitionOf(entry.hash)];
+                }
+                else if (length)
+                    ++skipped;
+
+                begin = next;
+            }
+
+            return skipped;
+        }
+
+        /**
+         *  @brief Returns the partition a hash belongs to.
+         *  @param hash The hash of a key.
+         *  @return The index of the partition.
+         */
+        size_t partitionOf(const uint32_t &hash) const
+        {
+            return mPartitionBits ? hash >> (32 - mPartitionBits) : 0;
+        }
+
+        /**
+         *  @brief Parses the mapped file on every thread and scatters the Entries into mEntries,
+         *  grouped by partition.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the entries.
+         */
+        void partition(void)
+        {
+            const char *data = static_cast<const char *>(mMapping);
+            size_t partitionCount = getPartitionCount();
+
+            // Chunks are cut at roughly equal sizes, then moved forward to the next line start
+            vector<size_t> chunkStarts(mThreadCount + 1, mMappingSize);
+            chunkStarts[0] = 0;
+
+            for (size_t threadIndex = 1; threadIndex < mThreadCount; threadIndex++)
+            {
+                size_t start = mMappingSize / mThreadCount * threadIndex;
+                if (start < chunkStarts[threadIndex - 1])
+                    start = chunkStarts[threadIndex - 1];
+
+                const char *newline = start < mMappingSize ?
+                                      static_cast<const char *>(memchr(data + start, '\n', mMappingSize - start)) : NULL;
+                chunkStarts[threadIndex] = newline ? newline - data + 1 : mMappingSize;
+            }
+
+            vector<vector<Entry> > chunkEntries(mThreadCount);
+            vector<vector<size_t> > chunkSizes(mThreadCount, vector<size_t>(partitionCount, 0));
+            vector<size_t> chunkSkipped(mThreadCount, 0);
+
+            runThreads([&](const size_t &threadIndex)
+            {
+                const char *begin = data + chunkStarts[threadIndex];
+                const char *end = data + chunkStarts[threadIndex + 1];
+
+                // Lines of dictionaries are short; this guess saves most reallocation
+                chunkEntries[threadIndex].reserve((end - begin) / 32);
+                chunkSkipped[threadIndex] = parse(begin, end, chunkEntries[threadIndex], chunkSizes[threadIndex]);
+            });
+
+            // Every thread writes each partition at its own offset, after the threads before it
+            mPartitionStarts.assign(partitionCount + 1, 0);
+            vector<vector<size_t> > writePositions(mThreadCount, vector<size_t>(partitionCount, 0));
+            size_t total = 0;
+
+            for (size_t partition = 0; partition < partitionCount; partition++)
+            {
+                mPartitionStarts[partition] = total;
+
+                for (size_t threadIndex = 0; threadIndex < mThreadCount; threadIndex++)
+                {
+                    writePositions[threadIndex][partition] = total;
+                    total += chunkSizes[threadIndex][partition];
+                }
+            }
+
+            mPartitionStarts[partitionCount] = total;
+            mEntries.resize(total);
+
+            runThreads([&](const size_t &threadIndex)
+            {
+                vector<Entry> &entries = chunkEntries[threadIndex];
+                vector<size_t> &positions = writePositions[threadIndex];
+
+                for (size_t index = 0; index < entries.size(); index++)
+                    mEntries[positions[partitionOf(entries[index].hash)]++] = entries[index];
+
+                vector<Entry>().swap(entries);
+            });
+
+            for (size_t threadIndex = 0; threadIndex < mThreadCount; threadIndex++)
+                mSkipped += chunkSkipped[threadIndex];
+        }
+};
+#endif // _INCLUDE_BULKLOADER_H_
@@ -0,0 +1,257 @@
+/**
+ *  @file ConcurrentHashTable.h
+ *  @brief Declaration for a string keyed HashTable that may be used from many threads at once.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_CONCURRENTHASHTABLE_H_
+#define _INCLUDE_CONCURRENTHASHTABLE_H_
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <stdint.h>
+#include <iostream>
+#include <shared_mutex>
+
+#include "HashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed, thread safe HashTable mapping string keys to pointers of storedType.
+ *  @param storedType The type of the values to point to in our ConcurrentHashTable.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail The keys are split over a power of two number of shards, each an ordinary HashTable
+ *  guarded by its own reader-writer lock. A key's shard is picked by the high bits of its hash,
+ *  leaving the low bits for the shard's own Bucket selection, and the hash is computed only once
+ *  per call. Lookups take their shard's lock shared and go through HashTable::findHashed(), which
+ *  never migrates Buckets, so readers of one shard never contend with each other; adds and
+ *  removals take it exclusively. Shards are cache line aligned so that the locks of neighbouring
+ *  shards do not share a line.
+ *  @note The ConcurrentHashTable does not own the values it points to. Synchronizing access to
+ *  the values themselves is up to the caller.
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class ConcurrentHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the number of shards.
+         *  @param shardCount The number of shards to split the keys over. It is rounded up to a
+         *  power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the shards.
+         */
+        ConcurrentHashTable(const size_t &shardCount = 64) : mShardBits(0)
+        {
+            while ((static_cast<size_t>(1) << mShardBits) < shardCount && mShardBits < MAX_SHARD_BITS)
+                ++mShardBits;
+
+            mShards = new Shard[getShardCount()];
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~ConcurrentHashTable(void)
+        {
+            delete[] mShards;
+        }
+
+        ConcurrentHashTable(const ConcurrentHashTable<storedType, hasherType> &) = delete;
+        ConcurrentHashTable<storedType, hasherType>& operator =(const ConcurrentHashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing a shard.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            return addHashed(key, value, HashTable<storedType, hasherType>::hashKey(key.data(), key.size()));
+        }
+
+        /**
+         *  @brief Associates value with key, using a hash the caller has already computed.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @param hash The hash of key as produced by HashTable::hashKey().
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing a shard.
+         */
+        bool addHashed(string_view key, storedType *value, const uint32_t &hash)
+        {
+            Shard &shard = shardFor(hash);
+
+            unique_lock<shared_mutex> lock(shard.lock);
+            return shard.table.addHashed(key, value, hash);
+        }
+
+        /**
+         *  @brief Grows every shard up front so that count keys spread evenly over them fit
+         *  without any shard growing again.
+         *  @param count The number of keys to make room for.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for a shard.
+         */
+        void reserve(const size_t &count)
+        {
+            // Shards fill unevenly; the slack covers several standard deviations of a fair split
+            size_t perShard = count / getShardCount();
+            perShard += perShard / 8 + 64;
+
+            for (size_t index = 0; index < getShardCount(); index++)
+            {
+                unique_lock<shared_mutex> lock(mShards[index].lock);
+                mShards[index].table.reserve(perShard);
+            }
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up. A string, string_view or C string may be passed without
+         *  copying it into a temporary string.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        storedType *find(string_view key) const
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+            Shard &shard = shardFor(hash);
+
+            shared_lock<shared_mutex> lock(shard.lock);
+            return shard.table.findHashed(key, hash);
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this ConcurrentHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes key and its value from this ConcurrentHashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+            Shard &shard = shardFor(hash);
+
+            unique_lock<shared_mutex> lock(shard.lock);
+            return shard.table.removeHashed(key, hash);
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this ConcurrentHashTable.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note Each shard is locked shared while it is visited, so the pairs seen are consistent
+         *  per shard but not across the ConcurrentHashTable as a whole.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t index = 0; index < getShardCount(); index++)
+            {
+                shared_lock<shared_mutex> lock(mShards[index].lock);
+                mShards[index].table.forEach(functor);
+            }
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this ConcurrentHashTable.
+         *  @return The number of keys currently stored. Concurrent modifications may make this
+         *  stale by the time it returns.
+         */
+        size_t getSize(void) const
+        {
+            size_t result = 0;
+
+            for (size_t index = 0; index < getShardCount(); index++)
+            {
+                shared_lock<shared_mutex> lock(mShards[index].lock);
+                result += mShards[index].table.getSize();
+            }
+
+            return result;
+        }
+
+        /**
+         *  @brief Returns the number of shards the keys are split over.
+         *  @return The shard count, which is a power of two.
+         */
+        size_t getShardCount(void) const
+        {
+            return static_cast<size_t>(1) << mShardBits;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a ConcurrentHashTable into a stream. Every value
+         *  is written on its own line, shard by shard.
+         *  @param stream The std::ostream to write into.
+         *  @param input The ConcurrentHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const ConcurrentHashTable<storedType, hasherType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](const string &, storedType *value)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << *value;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A HashTable and the lock guarding it, padded out to its own cache line.
+         */
+        struct alignas(64) Shard
+        {
+            //! Taken shared by lookups and exclusively by modifications.
+            mutable shared_mutex lock;
+            //! The keys whose hash selects this shard.
+            HashTable<storedType, hasherType> table;
+        };
+
+        //! The most hash bits used to pick a shard, leaving the rest for the shards themselves.
+        static constexpr size_t MAX_SHARD_BITS = 16;
+
+        //! The number of high hash bits that select a shard.
+        size_t mShardBits;
+        //! The shards.
+        Shard *mShards;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Returns the shard a hash belongs to.
+         *  @param hash The hash of a key.
+         *  @return A reference to the shard.
+         */
+        Shard &shardFor(const uint32_t &hash) const
+        {
+            return mShards[mShardBits ? hash >> (32 - mShardBits) : 0];
+        }
+};
+#endif // _INCLUDE_CONCURRENTHASHTABLE_H_
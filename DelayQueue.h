@@ -0,0 +1,343 @@
+/**
+ *  @file DelayQueue.h
+ *  @brief Declaration for a generically typed DelayQueue built on a hierarchical
+ *  timing wheel.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_DELAYQUEUE_H_
+#define _INCLUDE_DELAYQUEUE_H_
+
+#include <vector>
+#include <stdint.h>
+#include <iostream>
+
+using namespace std;
+
+/**
+ *  @brief A generically typed DelayQueue. Values are scheduled against an integer deadline
+ *  (in whatever tick unit the caller uses) and handed back by advance() once the clock passes it.
+ *  @param storedType The type to store in our DelayQueue.
+ *  @detail The DelayQueue is a hierarchical timing wheel: LEVEL_COUNT levels of SLOT_COUNT
+ *  buckets each, where a timer lives on the highest level at which its deadline differs from
+ *  the current time. Buckets are intrusive doubly linked lists of Timer nodes, so schedule()
+ *  and cancel() are O(1). When the clock reaches the start of a higher level bucket, that bucket
+ *  is cascaded down into the lower levels. A per level occupancy bitmap lets advance() jump
+ *  straight to the next non-empty bucket instead of visiting every tick.
+ */
+template <typename storedType>
+class DelayQueue
+{
+    // Public Members
+    public:
+        /**
+         *  A scheduled value. Pointers to Timers are handed out by schedule() and may be passed
+         *  to cancel() until the Timer has expired or been cancelled.
+         */
+        struct Timer
+        {
+            //! The value that this Timer contains.
+            storedType data;
+            //! The tick at which this Timer expires.
+            uint64_t deadline;
+            //! The previous Timer in the same bucket. NULL if this is the first.
+            Timer *pPrevious;
+            //! The next Timer in the same bucket, or in the free list. NULL if this is the last.
+            Timer *pNext;
+            //! The bucket this Timer is linked into. NULL while it sits in the free list.
+            Timer **pBucket;
+        };
+
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the initial time.
+         *  @param now The tick the DelayQueue starts at.
+         */
+        DelayQueue(const uint64_t &now = 0) : mCurrent(now), mSize(0), mFree(NULL)
+        {
+            for (size_t level = 0; level < LEVEL_COUNT; level++)
+            {
+                mOccupied[level] = 0;
+
+                for (size_t slot = 0; slot < SLOT_COUNT; slot++)
+                    mBuckets[level][slot] = NULL;
+            }
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~DelayQueue(void)
+        {
+            for (size_t level = 0; level < LEVEL_COUNT; level++)
+                for (size_t slot = 0; slot < SLOT_COUNT; slot++)
+                    freeChain(mBuckets[level][slot]);
+
+            freeChain(mFree);
+        }
+
+        /**
+         *  @brief Schedules a value to expire at the given deadline.
+         *  @param value The value to hand back once the deadline passes.
+         *  @param deadline The tick at which value expires. Deadlines at or before the last tick
+         *  passed to advance() are moved to the tick after it, so they expire on the first call
+         *  to advance() with a later tick.
+         *  @return A handle that can be given to cancel().
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Timer.
+         */
+        Timer *schedule(storedType value, uint64_t deadline)
+        {
+            Timer *timer = mFree;
+
+            if (timer)
+                mFree = timer->pNext;
+            else
+                timer = new Timer;
+
+            timer->data = value;
+            timer->deadline = deadline < mCurrent ? mCurrent : deadline;
+
+            link(timer);
+            ++mSize;
+            return timer;
+        }
+
+        /**
+         *  @brief Cancels a Timer so that it never expires.
+         *  @param timer A handle previously returned by schedule().
+         *  @return A boolean representing whether or not the Timer was cancelled.
+         *  @retval false Returned if timer is NULL.
+         *  @note The handle must not be used again once the Timer has expired or been cancelled.
+         */
+        bool cancel(Timer *timer)
+        {
+            if (!timer)
+                return false;
+
+            unlink(timer);
+            release(timer);
+            --mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Moves the clock forward, collecting every value whose deadline has passed.
+         *  @param now The new current tick. Nothing happens if this is earlier than the clock.
+         *  @param expired The std::vector the expired values are appended to, in deadline order.
+         *  @return The number of values that expired.
+         */
+        size_t advance(const uint64_t &now, vector<storedType> &expired)
+        {
+            size_t count = 0;
+
+            while (mCurrent <= now && mSize)
+            {
+                uint64_t next = nextEvent();
+
+                if (next > now)
+                    break;
+
+                mCurrent = next;
+
+                // Cascade every level whose bucket begins exactly at this tick, top down, so
+                // timers can fall through several levels in one step
+                for (size_t level = LEVEL_COUNT - 1; level > 0; level--)
+                {
+                    if (mCurrent & ((static_cast<uint64_t>(1) << (level * SLOT_BITS)) - 1))
+                        continue;
+
+                    size_t slot = slotFor(mCurrent, level);
+                    Timer *timer = mBuckets[level][slot];
+
+                    mBuckets[level][slot] = NULL;
+                    mOccupied[level] &= ~(static_cast<uint64_t>(1) << slot);
+
+                    while (timer)
+                    {
+                        Timer *next = timer->pNext;
+                        link(timer);
+                        timer = next;
+                    }
+                }
+
+                size_t slot = slotFor(mCurrent, 0);
+                Timer *timer = mBuckets[0][slot];
+
+                mBuckets[0][slot] = NULL;
+                mOccupied[0] &= ~(static_cast<uint64_t>(1) << slot);
+
+                while (timer)
+                {
+                    Timer *next = timer->pNext;
+
+                    expired.push_back(timer->data);
+                    release(timer);
+                    --mSize;
+                    ++count;
+
+                    timer = next;
+                }
+
+                ++mCurrent;
+            }
+
+            if (mCurrent <= now)
+                mCurrent = now + 1;
+
+            return count;
+        }
+
+        /**
+         *  @brief Returns the number of Timers still pending.
+         *  @return The number of Timers that have neither expired nor been cancelled.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns whether or not this DelayQueue is empty.
+         *  @return A boolean representing whether or not any Timers are pending.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+    // Private Members
+    private:
+        //! The number of bits of the deadline each level indexes.
+        static const size_t SLOT_BITS = 6;
+        //! The number of buckets per level. This matches the width of the occupancy bitmap.
+        static const size_t SLOT_COUNT = 1 << SLOT_BITS;
+        //! The number of levels needed to cover a full 64 bit deadline.
+        static const size_t LEVEL_COUNT = (64 + SLOT_BITS - 1) / SLOT_BITS;
+
+        //! The next tick that has not been processed yet.
+        uint64_t mCurrent;
+        //! The number of pending Timers.
+        size_t mSize;
+        //! Expired and cancelled Timers kept around for reuse.
+        Timer *mFree;
+        //! The buckets of every level, each the head of an intrusive list.
+        Timer *mBuckets[LEVEL_COUNT][SLOT_COUNT];
+        //! One bit per non-empty bucket of each level.
+        uint64_t mOccupied[LEVEL_COUNT];
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Returns the bucket index a tick maps to on the given level.
+         *  @param tick The tick to map.
+         *  @param level The level to map it on.
+         *  @return The bucket index.
+         */
+        static size_t slotFor(const uint64_t &tick, const size_t &level)
+        {
+            return static_cast<size_t>(tick >> (level * SLOT_BITS)) & (SLOT_COUNT - 1);
+        }
+
+        /**
+         *  @brief Links a Timer into the bucket its deadline currently maps to.
+         *  @param timer The Timer to link.
+         */
+        void link(Timer *timer)
+        {
+            uint64_t difference = timer->deadline ^ mCurrent;
+            size_t level = difference ? (63 - __builtin_clzll(difference)) / SLOT_BITS : 0;
+            size_t slot = slotFor(timer->deadline, level);
+            Timer **bucket = &mBuckets[level][slot];
+
+            timer->pPrevious = NULL;
+            timer->pNext = *bucket;
+            timer->pBucket = bucket;
+
+            if (*bucket)
+                (*bucket)->pPrevious = timer;
+
+            *bucket = timer;
+            mOccupied[level] |= static_cast<uint64_t>(1) << slot;
+        }
+
+        /**
+         *  @brief Unlinks a Timer from its bucket.
+         *  @param timer The Timer to unlink.
+         */
+        void unlink(Timer *timer)
+        {
+            if (timer->pPrevious)
+                timer->pPrevious->pNext = timer->pNext;
+            else
+                *timer->pBucket = timer->pNext;
+
+            if (timer->pNext)
+                timer->pNext->pPrevious = timer->pPrevious;
+
+            if (!*timer->pBucket)
+            {
+                size_t index = timer->pBucket - &mBuckets[0][0];
+                mOccupied[index / SLOT_COUNT] &= ~(static_cast<uint64_t>(1) << (index % SLOT_COUNT));
+            }
+        }
+
+        /**
+         *  @brief Puts a Timer into the free list.
+         *  @param timer The Timer to release.
+         */
+        void release(Timer *timer)
+        {
+            timer->pBucket = NULL;
+            timer->pNext = mFree;
+            mFree = timer;
+        }
+
+        /**
+         *  @brief Finds the earliest tick at or after the clock at which a bucket has to be
+         *  expired or cascaded.
+         *  @return The tick of the next event. Only meaningful while Timers are pending.
+         */
+        uint64_t nextEvent(void) const
+        {
+            uint64_t result = ~static_cast<uint64_t>(0);
+
+            for (size_t level = 0; level < LEVEL_COUNT; level++)
+            {
+                size_t shift = level * SLOT_BITS;
+                size_t current = slotFor(mCurrent, level);
+
+                // A higher level bucket can only match the clock's own slot when the clock
+                // sits exactly on its first tick, in which case it is due now
+                uint64_t candidates = mOccupied[level] >> current;
+
+                if (!candidates)
+                    continue;
+
+                size_t slot = current + __builtin_ctzll(candidates);
+                uint64_t base = shift + SLOT_BITS >= 64 ? 0 : (mCurrent >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+                uint64_t tick = base | (static_cast<uint64_t>(slot) << shift);
+
+                if (tick < result)
+                    result = tick;
+            }
+
+            return result;
+        }
+
+        /**
+         *  @brief Deletes every Timer of an intrusive list.
+         *  @param timer The first Timer of the list.
+         */
+        static void freeChain(Timer *timer)
+        {
+            while (timer)
+            {
+                Timer *next = timer->pNext;
+                delete timer;
+                timer = next;
+            }
+        }
+};
+#endif // _INCLUDE_DELAYQUEUE_H_
@@ -0,0 +1,347 @@
+/**
+ *  @file DurableHashTable.h
+ *  @brief Declaration for a string to string table whose adds survive the process, kept as a
+ *  snapshot file plus a write-ahead log of the adds since.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_DURABLEHASHTABLE_H_
+#define _INCLUDE_DURABLEHASHTABLE_H_
+
+#include <string>
+#include <stdint.h>
+#include <string_view>
+
+#include <sys/stat.h>
+
+#include "WriteAheadLog.h"
+#include "OwningHashTable.h"
+#include "MappedHashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief A string to string table kept durable in two files: a MappedHashTable snapshot and a
+ *  WriteAheadLog of every add made after the snapshot was written.
+ *  @detail add() appends a Record to the log before it changes the table, and commit() makes the
+ *  adds so far durable with one sync however many there were. Nothing is ever rewritten in
+ *  place, so an add costs a few bytes of log rather than a copy of the table.
+ *
+ *  Once the log outgrows a limit, commit() writes a checkpoint. The snapshot and the added pairs
+ *  are merged into a new snapshot file, which replaces the old one by a rename, and the log is
+ *  emptied. If the process dies between those two steps, the log only holds pairs the snapshot
+ *  has too, and replaying them changes nothing. open() maps the snapshot, which needs no
+ *  loading, and replays only the log, so startup time follows the log rather than the table.
+ *  @note The DurableHashTable must only be used by one thread at a time. Views returned by find()
+ *  and forEach() stay valid until the next add(), commit(), checkpoint() or close().
+ */
+class DurableHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the log size that triggers a checkpoint.
+         *  @param checkpointBytes commit() writes a checkpoint once the log is at least this
+         *  large and larger than the snapshot, so a checkpoint is never written for only a
+         *  small fraction of the table.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the snapshot.
+         */
+        DurableHashTable(const uint64_t &checkpointBytes = DEFAULT_CHECKPOINT_BYTES) : mSnapshot(new MappedHashTable()),
+        mAdded(NULL), mLast(0), mSize(0), mCheckpointBytes(checkpointBytes)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Commits any adds not yet committed.
+         */
+        ~DurableHashTable(void)
+        {
+            close();
+            delete mSnapshot;
+        }
+
+        DurableHashTable(const DurableHashTable &) = delete;
+        DurableHashTable& operator =(const DurableHashTable &) = delete;
+
+        /**
+         *  @brief Opens the files kept under a path, creating them if they do not exist, and
+         *  replays the log. Any files opened before are closed first.
+         *  @param path The path to keep the files under. The snapshot is path.snapshot and the
+         *  log path.log.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if the snapshot exists but is not a MappedHashTable file, or the
+         *  log could not be opened. The DurableHashTable is left closed.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the replayed pairs. The DurableHashTable is left closed.
+         */
+        bool open(const string &path)
+        {
+            close();
+
+            mSnapshotPath = path + ".snapshot";
+
+            struct stat status;
+            if (!stat(mSnapshotPath.c_str(), &status) && !mSnapshot->open(mSnapshotPath))
+                return false;
+
+            mSize = mSnapshot->getSize();
+
+            bool opened;
+            try
+            {
+                mAdded = new OwningHashTable<string>();
+                opened = mLog.open(path + ".log", [this](string_view key, string_view value) { apply(key, value); });
+            }
+            catch (...)
+            {
+                close();
+                throw;
+            }
+
+            if (!opened)
+                close();
+
+            return opened;
+        }
+
+        /**
+         *  @brief Commits any adds not yet committed and closes the files, leaving the
+         *  DurableHashTable empty.
+         */
+        void close(void)
+        {
+            mLog.close();
+            mSnapshot->close();
+
+            delete mAdded;
+            mAdded = NULL;
+            mSize = 0;
+        }
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key. The pair
+         *  is logged before the table changes, but is only durable once commit() has returned.
+         *  @param key The key to store value under.
+         *  @param value The value to store.
+         *  @return A boolean representing whether or not the pair was logged and added.
+         *  @retval false Returned if the DurableHashTable is not open, or writing the log has
+         *  failed. The table is unchanged.
+         *  @throw length_error Thrown when key or value is longer than the log can hold.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap. The pair may have been logged, and will then be added by the next open().
+         */
+        bool add(string_view key, string_view value)
+        {
+            uint64_t sequence;
+
+            if (!mLog.append(key, value, sequence))
+                return false;
+
+            mLast = sequence;
+            apply(key, value);
+            return true;
+        }
+
+        /**
+         *  @brief Makes every add so far durable, then writes a checkpoint if the log has grown
+         *  past its limit.
+         *  @return A boolean representing whether or not every add so far is durable.
+         *  @retval false Returned if the DurableHashTable is not open, or writing the log has
+         *  failed. The adds stay in the table until it is closed, but will not be there after
+         *  the next open().
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while writing a checkpoint. The adds are durable regardless.
+         */
+        bool commit(void)
+        {
+            if (!mLog.commit(mLast) || !mLog.isOpen())
+                return false;
+
+            uint64_t logSize = mLog.getSize();
+            struct stat status;
+
+            if (logSize >= mCheckpointBytes &&
+                (stat(mSnapshotPath.c_str(), &status) || logSize > static_cast<uint64_t>(status.st_size)))
+                checkpoint();
+
+            return true;
+        }
+
+        /**
+         *  @brief Writes every pair into a new snapshot and drops the Records it covers from the log.
+         *  @return A boolean representing whether or not the checkpoint was written.
+         *  @retval false Returned if the DurableHashTable is not open, or the new snapshot could
+         *  not be written. The files and the table are as they were.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while merging the pairs. The files and the table are as they were.
+         */
+        bool checkpoint(void)
+        {
+            if (!mLog.isOpen())
+                return false;
+
+            MappedHashTableWriter writer;
+            uint64_t covered = mLast;
+
+            // The writer keeps the value added last, so added pairs override the snapshot
+            mSnapshot->forEach([&writer](string_view key, string_view value) { writer.add(key, value); });
+            mAdded->forEach([&writer](const string &key, string *value) { writer.add(key, *value); });
+
+            MappedHashTable *snapshot = new MappedHashTable();
+            OwningHashTable<string> *added;
+
+            try
+            {
+                added = new OwningHashTable<string>();
+            }
+            catch (...)
+            {
+                delete snapshot;
+                throw;
+            }
+
+            if (!writer.write(mSnapshotPath) || !WriteAheadLog::syncDirectory(mSnapshotPath) ||
+                !snapshot->open(mSnapshotPath))
+            {
+                delete added;
+                delete snapshot;
+                return false;
+            }
+
+            // Should dropping the Records the snapshot covers fail, replaying them onto it changes nothing
+            mLog.reset(covered);
+
+            delete mSnapshot;
+            delete mAdded;
+            mSnapshot = snapshot;
+            mAdded = added;
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @param value Assigned a view of the value if key is present.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool find(string_view key, string_view &value) const
+        {
+            string *added = mAdded ? mAdded->find(key) : NULL;
+
+            if (added)
+            {
+                value = *added;
+                return true;
+            }
+
+            return mSnapshot->find(key, value);
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this DurableHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            string_view value;
+            return this->find(key, value);
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this DurableHashTable.
+         *  @param functor A callable accepting two string_views, the key and the value.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            if (!mAdded)
+                return;
+
+            mAdded->forEach([&functor](const string &key, string *value) { functor(string_view(key), string_view(*value)); });
+
+            const OwningHashTable<string> &added = *mAdded;
+            mSnapshot->forEach([&functor, &added](string_view key, string_view value)
+            {
+                if (!added.contains(key))
+                    functor(key, value);
+            });
+        }
+
+        /**
+         *  @brief Returns whether or not the files are open.
+         *  @return A boolean representing whether or not open() has succeeded since the last close().
+         */
+        bool isOpen(void) const
+        {
+            return mLog.isOpen();
+        }
+
+        /**
+         *  @brief Returns the number of keys in this DurableHashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns whether or not this DurableHashTable is empty.
+         *  @return A boolean representing whether or not this DurableHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         *  @brief Returns the log, for inspection.
+         *  @return A reference to the WriteAheadLog.
+         */
+        const WriteAheadLog &getLog(void) const
+        {
+            return mLog;
+        }
+
+    // Private Members
+    private:
+        //! The log size that triggers a checkpoint by default.
+        static constexpr uint64_t DEFAULT_CHECKPOINT_BYTES = 16 << 20;
+
+        //! The pairs as of the last checkpoint.
+        MappedHashTable *mSnapshot;
+        //! The pairs added since the last checkpoint. NULL while closed.
+        OwningHashTable<string> *mAdded;
+        //! The adds since the last checkpoint.
+        WriteAheadLog mLog;
+        //! The path of the snapshot file.
+        string mSnapshotPath;
+        //! The sequence number of the last add, for commit().
+        uint64_t mLast;
+        //! The number of distinct keys in mSnapshot and mAdded.
+        size_t mSize;
+        //! The log size that triggers a checkpoint.
+        uint64_t mCheckpointBytes;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Adds a pair to the table, without logging it.
+         *  @param key The key to store value under.
+         *  @param value The value to store.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap. The table is unchanged.
+         */
+        void apply(string_view key, string_view value)
+        {
+            bool added = !mAdded->contains(key) && !mSnapshot->contains(key);
+
+            mAdded->emplace(key, value);
+            if (added)
+                ++mSize;
+        }
+};
+#endif // _INCLUDE_DURABLEHASHTABLE_H_
@@ -0,0 +1,297 @@
+/**
+ *  @file EpochReclaimer.h
+ *  @brief Declaration for an epoch based memory reclaimer that lets readers traverse shared
+ *  structures without locks.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_EPOCHRECLAIMER_H_
+#define _INCLUDE_EPOCHRECLAIMER_H_
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ *  @brief Defers freeing memory that lock free readers may still be looking at.
+ *  @detail Readers wrap every traversal in a Guard, which announces the global epoch the reader
+ *  started in. Writers unlink memory first and then retire() it, tagging it with the current
+ *  epoch. The global epoch only advances once every active reader has announced it, so once it
+ *  has moved two steps past an item's tag no reader can still hold a pointer to that item and
+ *  it is freed.
+ *
+ *  Each Guard claims a Participant record for the duration of the read. A thread caches the
+ *  record it used last, so in the common case entering a Guard is one uncontended exchange on a
+ *  cache line nobody else writes, followed by a store of the epoch.
+ */
+class EpochReclaimer
+{
+    // Private Members
+    private:
+        /**
+         *  The announcement of one reader, padded out to its own cache line.
+         */
+        struct alignas(64) Participant
+        {
+            //! Constructs an unclaimed Participant.
+            Participant(void) : inUse(false), epoch(IDLE), pNext(NULL)
+            {
+
+            }
+
+            //! Whether or not a Guard currently owns this Participant.
+            atomic<bool> inUse;
+            //! The epoch the owning reader entered in, or IDLE.
+            atomic<uint64_t> epoch;
+            //! The next Participant of the reclaimer. NULL if this is the last.
+            Participant *pNext;
+        };
+
+    // Public Members
+    public:
+        /**
+         *  @brief Marks the calling thread as reading for as long as the Guard lives. Pointers
+         *  loaded from the protected structure stay valid until the Guard is destroyed.
+         */
+        class Guard
+        {
+            // Public Methods
+            public:
+                /**
+                 *  @brief Constructor accepting the reclaimer protecting the structure.
+                 *  @param reclaimer The EpochReclaimer to announce the read to.
+                 *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+                 *  the heap for a new Participant.
+                 */
+                explicit Guard(EpochReclaimer &reclaimer) : mParticipant(reclaimer.acquire())
+                {
+                    mParticipant->epoch.store(reclaimer.mEpoch.load(memory_order_relaxed), memory_order_relaxed);
+
+                    // The announcement must be visible before any protected pointer is loaded
+                    atomic_thread_fence(memory_order_seq_cst);
+                }
+
+                /**
+                 *  @brief Standard destructor. Ends the read.
+                 */
+                ~Guard(void)
+                {
+                    mParticipant->epoch.store(IDLE, memory_order_release);
+                    mParticipant->inUse.store(false, memory_order_release);
+                }
+
+                Guard(const Guard &) = delete;
+                Guard& operator =(const Guard &) = delete;
+
+            // Private Members
+            private:
+                //! The Participant claimed for this read.
+                Participant *mParticipant;
+        };
+
+    // Public Methods
+    public:
+        /**
+         *  @brief Parameter-less constructor.
+         */
+        EpochReclaimer(void) : mId(sNextId.fetch_add(1)), mEpoch(FIRST_EPOCH), mParticipants(NULL)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Frees everything still retired; no Guard may be alive.
+         */
+        ~EpochReclaimer(void)
+        {
+            for (size_t index = 0; index < mRetired.size(); index++)
+                mRetired[index].deleter(mRetired[index].pointer);
+
+            Participant *current = mParticipants.load(memory_order_acquire);
+            while (current)
+            {
+                Participant *next = current->pNext;
+                delete current;
+                current = next;
+            }
+        }
+
+        EpochReclaimer(const EpochReclaimer &) = delete;
+        EpochReclaimer& operator =(const EpochReclaimer &) = delete;
+
+        /**
+         *  @brief Hands memory that has already been unlinked from the protected structure over
+         *  to be freed once no reader can reach it anymore.
+         *  @param pointer The memory to free.
+         *  @param deleter Called with pointer to free it.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the retire list.
+         */
+        void retire(void *pointer, void (*deleter)(void *))
+        {
+            lock_guard<mutex> lock(mRetiredLock);
+
+            Retired entry;
+            entry.pointer = pointer;
+            entry.deleter = deleter;
+            entry.epoch = mEpoch.load(memory_order_relaxed);
+            mRetired.push_back(entry);
+
+            if (mRetired.size() >= RECLAIM_THRESHOLD)
+                reclaim();
+        }
+
+        /**
+         *  @brief Hands an object that has already been unlinked over to be deleted once no
+         *  reader can reach it anymore.
+         *  @param pointer The object to delete.
+         */
+        template <typename objectType>
+        void retire(objectType *pointer)
+        {
+            retire(pointer, [](void *object) { delete static_cast<objectType *>(object); });
+        }
+
+        /**
+         *  @brief Tries to advance the epoch and frees whatever that makes unreachable.
+         *  @return The number of retired items still waiting to be freed.
+         */
+        size_t collect(void)
+        {
+            lock_guard<mutex> lock(mRetiredLock);
+
+            reclaim();
+            reclaim();
+            return mRetired.size();
+        }
+
+    // Private Members
+    private:
+        /**
+         *  Memory waiting to be freed.
+         */
+        struct Retired
+        {
+            //! The memory to free.
+            void *pointer;
+            //! Frees pointer.
+            void (*deleter)(void *);
+            //! The global epoch when the memory was retired.
+            uint64_t epoch;
+        };
+
+        //! The epoch announced by a Participant outside of a Guard.
+        static constexpr uint64_t IDLE = 0;
+        //! The first global epoch. It is past IDLE so the two are never confused.
+        static constexpr uint64_t FIRST_EPOCH = 1;
+        //! The retire list is reclaimed every time it reaches this size.
+        static constexpr size_t RECLAIM_THRESHOLD = 64;
+
+        //! Hands out unique ids, which let threads tell reclaimers apart even across reuse of an address.
+        static inline atomic<uint64_t> sNextId = 1;
+
+        /**
+         *  The Participant a thread used last, and the reclaimer it belongs to.
+         */
+        struct CachedParticipant
+        {
+            //! The id of the reclaimer, or zero if nothing is cached.
+            uint64_t reclaimerId;
+            //! The Participant.
+            Participant *participant;
+        };
+
+        //! The Participant each thread used last.
+        static inline thread_local CachedParticipant sCached = { 0, NULL };
+
+        //! The unique id of this reclaimer.
+        const uint64_t mId;
+        //! The global epoch.
+        atomic<uint64_t> mEpoch;
+        //! Every Participant ever created, newest first. Participants are only freed with the reclaimer.
+        atomic<Participant *> mParticipants;
+        //! Guards mRetired.
+        mutex mRetiredLock;
+        //! Memory waiting to be freed, oldest first.
+        vector<Retired> mRetired;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Claims a Participant for the calling thread, preferring the one it used last.
+         *  @return The claimed Participant.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for a new Participant.
+         */
+        Participant *acquire(void)
+        {
+            // The id check guarantees the cached Participant belongs to this, still living, reclaimer
+            if (sCached.reclaimerId == mId && !sCached.participant->inUse.exchange(true, memory_order_acquire))
+                return sCached.participant;
+
+            Participant *result = NULL;
+            for (Participant *current = mParticipants.load(memory_order_acquire); current; current = current->pNext)
+                if (!current->inUse.load(memory_order_relaxed) && !current->inUse.exchange(true, memory_order_acquire))
+                {
+                    result = current;
+                    break;
+                }
+
+            if (!result)
+            {
+                result = new Participant;
+                result->inUse.store(true, memory_order_relaxed);
+                result->pNext = mParticipants.load(memory_order_relaxed);
+
+                while (!mParticipants.compare_exchange_weak(result->pNext, result, memory_order_release,
+                                                            memory_order_relaxed))
+                    ;
+            }
+
+            sCached.reclaimerId = mId;
+            sCached.participant = result;
+            return result;
+        }
+
+        /**
+         *  @brief Advances the global epoch if every active reader has caught up with it, then
+         *  frees every retired item at least two epochs old. mRetiredLock must be held.
+         */
+        void reclaim(void)
+        {
+            // Unlinking happened before retire(); order it before reading the announcements
+            atomic_thread_fence(memory_order_seq_cst);
+
+            uint64_t epoch = mEpoch.load(memory_order_relaxed);
+            bool caughtUp = true;
+
+            for (Participant *current = mParticipants.load(memory_order_acquire); current; current = current->pNext)
+            {
+                uint64_t announced = current->epoch.load(memory_order_acquire);
+
+                if (announced != IDLE && announced != epoch)
+                {
+                    caughtUp = false;
+                    break;
+                }
+            }
+
+            if (caughtUp)
+                mEpoch.store(++epoch, memory_order_release);
+
+            size_t kept = 0;
+            for (size_t index = 0; index < mRetired.size(); index++)
+            {
+                if (mRetired[index].epoch + 2 <= epoch)
+                    mRetired[index].deleter(mRetired[index].pointer);
+                else
+                    mRetired[kept++] = mRetired[index];
+            }
+
+            mRetired.resize(kept);
+        }
+};
+#endif // _INCLUDE_EPOCHRECLAIMER_H_
@@ -0,0 +1,144 @@
+/**
+ *  @file Executor.h
+ *  @brief Declaration for a single-threaded coroutine Executor and the fire-and-forget
+ *  Task type it runs.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_EXECUTOR_H_
+#define _INCLUDE_EXECUTOR_H_
+
+#include <coroutine>
+#include <exception>
+
+#include "Queue.h"
+
+using namespace std;
+
+/**
+ *  @brief A fire-and-forget coroutine type. A Task starts suspended and is started by
+ *  handing it to an Executor; its frame destroys itself once the coroutine body returns.
+ */
+class Task
+{
+    // Public Members
+    public:
+        /**
+         *  @brief The promise type the compiler uses to build coroutines returning Task.
+         */
+        struct promise_type
+        {
+            //! Produces the Task object handed back to the caller of the coroutine.
+            Task get_return_object(void)
+            {
+                return Task(coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            //! Tasks do not run until they have been spawned on an Executor.
+            suspend_always initial_suspend(void) noexcept { return suspend_always(); }
+            //! The frame is released as soon as the body completes.
+            suspend_never final_suspend(void) noexcept { return suspend_never(); }
+            //! Tasks produce no value.
+            void return_void(void) { }
+            //! There is nobody to rethrow to, so escaping exceptions are fatal.
+            void unhandled_exception(void) { terminate(); }
+        };
+
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the handle of the coroutine this Task wraps.
+         *  @param handle The coroutine handle produced by the promise.
+         */
+        explicit Task(coroutine_handle<promise_type> handle) : mHandle(handle)
+        {
+
+        }
+
+        /**
+         *  @brief Releases ownership of the wrapped coroutine.
+         *  @return The handle of the coroutine. This Task no longer refers to it afterwards.
+         */
+        coroutine_handle<> release(void)
+        {
+            coroutine_handle<> result = mHandle;
+            mHandle = NULL;
+            return result;
+        }
+
+        /**
+         *  @brief Standard destructor. Destroys the coroutine if it was never spawned.
+         */
+        ~Task(void)
+        {
+            if (mHandle)
+                mHandle.destroy();
+        }
+
+        Task(const Task &) = delete;
+        Task& operator =(const Task &) = delete;
+
+    // Private Members
+    private:
+        //! The coroutine this Task wraps, or NULL once it has been released.
+        coroutine_handle<promise_type> mHandle;
+};
+
+/**
+ *  @brief A single-threaded Executor. Coroutines that are ready to continue are queued
+ *  with schedule() and resumed in FIFO order by run().
+ */
+class Executor
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Hands a Task to this Executor. It will first run on the next call to run().
+         *  @param task The Task to start.
+         */
+        void spawn(Task task)
+        {
+            mReady.add(task.release());
+        }
+
+        /**
+         *  @brief Queues a suspended coroutine to be resumed by run().
+         *  @param handle The coroutine to resume.
+         */
+        void schedule(coroutine_handle<> handle)
+        {
+            mReady.add(handle);
+        }
+
+        /**
+         *  @brief Resumes queued coroutines until none are left ready to run.
+         *  @return The number of coroutines that were resumed.
+         */
+        size_t run(void)
+        {
+            size_t resumed = 0;
+
+            while (!mReady.isEmpty())
+            {
+                mReady.pop().resume();
+                ++resumed;
+            }
+
+            return resumed;
+        }
+
+        /**
+         *  @brief Returns whether or not anything is waiting to be resumed.
+         *  @return A boolean representing whether or not the ready queue is empty.
+         */
+        bool isIdle(void) const
+        {
+            return mReady.isEmpty();
+        }
+
+    // Private Members
+    private:
+        //! Coroutines waiting to be resumed, in the order they became ready.
+        Queue<coroutine_handle<> > mReady;
+};
+#endif // _INCLUDE_EXECUTOR_H_
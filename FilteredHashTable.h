@@ -0,0 +1,240 @@
+/**
+ *  @file FilteredHashTable.h
+ *  @brief Declaration for a HashTable fronted by a BloomFilter so that lookups for absent keys
+ *  rarely touch the table.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_FILTEREDHASHTABLE_H_
+#define _INCLUDE_FILTEREDHASHTABLE_H_
+
+#include <string>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+#include "Hashers.h"
+#include "HashTable.h"
+#include "BloomFilter.h"
+
+using namespace std;
+
+/**
+ *  @brief A HashTable mapping string keys to pointers of storedType, with a BloomFilter of its
+ *  keys that every lookup consults first.
+ *  @param storedType The type of the values to point to in our FilteredHashTable.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail Each key is hashed once; the full 64 bits feed the BloomFilter and the folded 32 bits
+ *  the HashTable. When most lookups are for absent keys, most of them end at the one cache line
+ *  of the filter instead of probing the much larger Bucket array.
+ *
+ *  The filter is sized for an expected number of keys and rebuilt from the table, twice as
+ *  large, once more keys than that have been added. Since a BloomFilter cannot forget a key,
+ *  removed keys linger in it as extra false positives until they make up half of it, at which
+ *  point it is rebuilt as well.
+ *  @note The FilteredHashTable does not own the values it points to.
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class FilteredHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the expected number of keys and the false positive rate
+         *  of the filter.
+         *  @param expectedCount The number of keys to size the table and the filter for.
+         *  @param falsePositiveRate The fraction of lookups for absent keys that may get past the
+         *  filter and probe the table.
+         *  @throw invalid_argument Thrown when falsePositiveRate is not between 0 and 1.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the table or the filter.
+         */
+        FilteredHashTable(const size_t &expectedCount = 16, const double &falsePositiveRate = 0.01) :
+        mTable(expectedCount * 8 / 7 + 1), mFilter(NULL), mFalsePositiveRate(falsePositiveRate), mStale(0)
+        {
+            mFilter = new BloomFilter(expectedCount < MIN_FILTER_COUNT ? MIN_FILTER_COUNT : expectedCount,
+                                      falsePositiveRate);
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~FilteredHashTable(void)
+        {
+            delete mFilter;
+        }
+
+        FilteredHashTable(const FilteredHashTable<storedType, hasherType> &) = delete;
+        FilteredHashTable<storedType, hasherType>& operator =(const FilteredHashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the table or the filter. The FilteredHashTable is unchanged.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            uint64_t hash = hasherType::hash(key.data(), key.size());
+
+            // Growing the filter first means nothing can fail once the table has changed
+            if (mFilter->getSize() >= mFilter->getExpectedCount())
+                rebuildFilter(mFilter->getExpectedCount() * 2);
+
+            if (!mTable.addHashed(key, value, HashTable<storedType, hasherType>::foldHash(hash)))
+                return false;
+
+            mFilter->add(hash);
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         *  @note This never modifies anything, so any number of threads may call it at once as
+         *  long as nothing modifies the FilteredHashTable meanwhile.
+         */
+        storedType *find(string_view key) const
+        {
+            uint64_t hash = hasherType::hash(key.data(), key.size());
+
+            if (!mFilter->mayContain(hash))
+                return NULL;
+
+            return mTable.findHashed(key, HashTable<storedType, hasherType>::foldHash(hash));
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this FilteredHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes key and its value from this FilteredHashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while rebuilding the filter. The key has been removed regardless.
+         */
+        bool remove(string_view key)
+        {
+            uint64_t hash = hasherType::hash(key.data(), key.size());
+
+            if (!mTable.removeHashed(key, HashTable<storedType, hasherType>::foldHash(hash)))
+                return false;
+
+            if (++mStale * 2 > mFilter->getSize())
+                rebuildFilter(mFilter->getExpectedCount());
+
+            return true;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this FilteredHashTable.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note The FilteredHashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            mTable.forEach(functor);
+        }
+
+        /**
+         *  @brief Returns the filter in front of the table, for inspection.
+         *  @return A reference to the BloomFilter.
+         */
+        const BloomFilter &getFilter(void) const
+        {
+            return *mFilter;
+        }
+
+        /**
+         *  @brief Returns the number of keys in this FilteredHashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mTable.getSize();
+        }
+
+        /**
+         *  @brief Returns the number of Buckets of the table.
+         *  @return The current capacity of the table.
+         */
+        size_t getCapacity(void) const
+        {
+            return mTable.getCapacity();
+        }
+
+        /**
+         *  @brief Returns whether or not this FilteredHashTable is empty.
+         *  @return A boolean representing whether or not this FilteredHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mTable.isEmpty();
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a FilteredHashTable into a stream.
+         *  @param stream The std::ostream to write into.
+         *  @param input The FilteredHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const FilteredHashTable<storedType, hasherType> &input)
+        {
+            return stream << input.mTable;
+        }
+
+    // Private Members
+    private:
+        //! The smallest number of keys the filter is sized for.
+        static constexpr size_t MIN_FILTER_COUNT = 64;
+
+        //! The table holding the keys and values.
+        HashTable<storedType, hasherType> mTable;
+        //! The filter of the keys in mTable, plus any removed since it was last rebuilt.
+        BloomFilter *mFilter;
+        //! The false positive rate the filter is sized for.
+        double mFalsePositiveRate;
+        //! The number of keys removed from mTable since the filter was last rebuilt.
+        size_t mStale;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Replaces the filter with one holding exactly the keys of the table.
+         *  @param expectedCount The number of keys to size the new filter for. It is raised to
+         *  twice the number of keys in the table if that is larger.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new filter. The old filter is kept.
+         */
+        void rebuildFilter(size_t expectedCount)
+        {
+            if (expectedCount < mTable.getSize() * 2)
+                expectedCount = mTable.getSize() * 2;
+
+            BloomFilter *filter = new BloomFilter(expectedCount, mFalsePositiveRate);
+
+            mTable.forEach([filter](const string &key, storedType *)
+            {
+                filter->add(hasherType::hash(key.data(), key.size()));
+            });
+
+            delete mFilter;
+            mFilter = filter;
+            mStale = 0;
+        }
+};
+#endif // _INCLUDE_FILTEREDHASHTABLE_H_
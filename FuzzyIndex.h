@@ -0,0 +1,489 @@
+/**
+ *  @file FuzzyIndex.h
+ *  @brief Declaration for an index that finds the keys within a small edit distance of a query,
+ *  and for the bit-parallel edit distance kernel it verifies candidates with.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_FUZZYINDEX_H_
+#define _INCLUDE_FUZZYINDEX_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+#include "Arena.h"
+#include "Hashers.h"
+
+using namespace std;
+
+/**
+ *  @brief Computes the Levenshtein distance from one fixed pattern to any number of texts.
+ *  @detail Patterns of up to 64 characters use Myers' bit-parallel algorithm, in Hyyrö's
+ *  formulation for whole string distance: a column of the dynamic programming matrix is held as
+ *  bit vectors of its vertical deltas, and a whole column is advanced with a dozen word
+ *  operations per text character. The per character match masks only depend on the pattern and
+ *  are computed once by the constructor. Longer patterns fall back to the classic two row
+ *  dynamic program.
+ *  @note The EditDistanceMatcher refers to the characters of the pattern, which must outlive it.
+ */
+class EditDistanceMatcher
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the pattern.
+         *  @param pattern The string to measure texts against.
+         */
+        EditDistanceMatcher(string_view pattern) : mPattern(pattern)
+        {
+            memset(mMatches, 0, sizeof(mMatches));
+
+            if (pattern.size() <= WORD_BITS)
+                for (size_t index = 0; index < pattern.size(); index++)
+                    mMatches[static_cast<unsigned char>(pattern[index])] |= 1ULL << index;
+        }
+
+        /**
+         *  @brief Measures the edit distance from the pattern to text, giving up once it is
+         *  certain to exceed limit.
+         *  @param text The string to measure.
+         *  @param limit The largest distance of interest.
+         *  @return The number of single character insertions, deletions and substitutions that
+         *  turn the pattern into text, or limit + 1 if that is more than limit.
+         */
+        uint32_t measure(string_view text, const uint32_t &limit) const
+        {
+            size_t difference = text.size() > mPattern.size() ? text.size() - mPattern.size() : mPattern.size() - text.size();
+            if (difference > limit)
+                return limit + 1;
+
+            if (mPattern.empty())
+                return static_cast<uint32_t>(text.size());
+
+            if (mPattern.size() > WORD_BITS)
+                return measureLong(text, limit);
+
+            uint64_t positive = ~0ULL;
+            uint64_t negative = 0;
+            uint64_t last = 1ULL << (mPattern.size() - 1);
+            size_t score = mPattern.size();
+
+            for (size_t index = 0; index < text.size(); index++)
+            {
+                uint64_t match = mMatches[static_cast<unsigned char>(text[index])];
+                uint64_t vertical = match | negative;
+                uint64_t horizontal = (((match & positive) + positive) ^ positive) | match;
+                uint64_t horizontalPositive = negative | ~(horizontal | positive);
+                uint64_t horizontalNegative = positive & horizontal;
+
+                if (horizontalPositive & last)
+                    ++score;
+                else if (horizontalNegative & last)
+                    --score;
+
+                // The top row of the matrix counts up by one per text character
+                horizontalPositive = (horizontalPositive << 1) | 1;
+                horizontalNegative <<= 1;
+
+                positive = horizontalNegative | ~(vertical | horizontalPositive);
+                negative = horizontalPositive & vertical;
+
+                // The bottom row can fall by at most one per remaining text character
+                size_t remaining = text.size() - index - 1;
+                if (score > limit + remaining)
+                    return limit + 1;
+            }
+
+            return score > limit ? limit + 1 : static_cast<uint32_t>(score);
+        }
+
+    // Private Members
+    private:
+        //! The longest pattern the bit-parallel algorithm handles.
+        static constexpr size_t WORD_BITS = 64;
+
+        //! The pattern.
+        string_view mPattern;
+        //! For every character, the positions of the pattern holding it as a bit mask.
+        uint64_t mMatches[256];
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Measures the edit distance for a pattern too long for one word.
+         *  @param text The string to measure.
+         *  @param limit The largest distance of interest.
+         *  @return The edit distance, or limit + 1 if that is more than limit.
+         */
+        uint32_t measureLong(string_view text, const uint32_t &limit) const
+        {
+            vector<size_t> previous(text.size() + 1);
+            vector<size_t> current(text.size() + 1);
+
+            for (size_t column = 0; column <= text.size(); column++)
+                previous[column] = column;
+
+            for (size_t row = 1; row <= mPattern.size(); row++)
+            {
+                current[0] = row;
+                size_t smallest = row;
+
+                for (size_t column = 1; column <= text.size(); column++)
+                {
+                    size_t substitution = previous[column - 1] + (mPattern[row - 1] != text[column - 1]);
+                    size_t deletion = previous[column] + 1;
+                    size_t insertion = current[column - 1] + 1;
+
+                    current[column] = min(substitution, min(deletion, insertion));
+                    smallest = min(smallest, current[column]);
+                }
+
+                // Values never decrease down a diagonal, so a row entirely over the limit ends it
+                if (smallest > limit)
+                    return limit + 1;
+
+                previous.swap(current);
+            }
+
+            return previous[text.size()] > limit ? limit + 1 : static_cast<uint32_t>(previous[text.size()]);
+        }
+};
+
+/**
+ *  @brief An index of string keys that finds every key within a given edit distance of a
+ *  query, to suggest corrections for misspelled words.
+ *  @detail Symmetric deletion, after SymSpell: two strings are within edit distance k only if
+ *  deleting at most k characters from each can make them equal. build() therefore records the
+ *  hash of every string obtained by deleting up to maxDistance characters from each key, and a
+ *  search generates the same deletions of the query and looks their hashes up, which yields a
+ *  small set of candidates without looking at any other key. Candidates, including those that
+ *  only share a hash, are then verified with an EditDistanceMatcher.
+ *
+ *  Only the first prefixLength characters of keys and queries are used for the deletions. This
+ *  loses no matches, since the prefixes of two strings within distance k are themselves within
+ *  k deletions of each other, and caps the deletions per key however long it is.
+ *
+ *  The deletion hashes live in one sorted array of hash and key number pairs, 8 bytes each,
+ *  with a directory on the top bits of the hash so that a lookup scans a handful of entries.
+ *  Keys added after build() are kept in a pending list that every search checks directly until
+ *  the index is rebuilt, which add() does by itself once the list is long enough.
+ *  @note Keys cannot be removed.
+ */
+class FuzzyIndex
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief A key found by search().
+         */
+        struct Match
+        {
+            //! The key. It stays valid until the next key is added.
+            string_view key;
+            //! The edit distance from the query to the key.
+            uint32_t distance;
+        };
+
+        /**
+         *  @brief Constructor accepting the largest edit distance to index for and the number of
+         *  leading characters the deletions are taken from.
+         *  @param maxDistance The largest distance search() can be asked for. The index grows
+         *  steeply with it; 2 catches most typing mistakes.
+         *  @param prefixLength The number of leading characters of each key to delete from. Longer
+         *  prefixes give fewer candidates per search but more deletions per key.
+         *  @throw invalid_argument Thrown when prefixLength exceeds MAX_PREFIX_LENGTH.
+         */
+        FuzzyIndex(const uint32_t &maxDistance = 2, const size_t &prefixLength = 7) : mMaxDistance(maxDistance),
+        mPrefixLength(prefixLength), mIndexedCount(0), mShift(31), mBuilt(false)
+        {
+            if (prefixLength > MAX_PREFIX_LENGTH)
+                throw invalid_argument("FuzzyIndex prefix length is too long");
+
+            // An empty one bit directory, so that searching before the first build() finds nothing
+            mDirectory.assign(3, 0);
+        }
+
+        /**
+         *  @brief Adds a key. It can be found right away, through the pending list until the next
+         *  build(). Before the first build() keys only accumulate, so loading many keys should end
+         *  with a call to build().
+         *  @param key The key to add. Adding a key twice is harmless; it is reported once.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the key or for rebuilding the index.
+         */
+        void add(string_view key)
+        {
+            mOffsets.push_back(mKeys.add(key, 0));
+
+            // Rebuilding once the pending keys reach a fraction of the indexed ones keeps the cost per key constant
+            size_t pending = mOffsets.size() - mIndexedCount;
+            if (mBuilt && pending >= MAX_PENDING_KEYS && pending >= mIndexedCount / PENDING_FRACTION)
+                build();
+        }
+
+        /**
+         *  @brief Adds every key of a table, such as a HashTable, OwningHashTable or
+         *  MappedHashTable, and builds the index.
+         *  @param table The table to take the keys of. Its forEach() must pass the key first.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the keys or the index.
+         */
+        template <typename tableType>
+        void addAll(const tableType &table)
+        {
+            table.forEach([this](string_view key, auto &&)
+            {
+                mOffsets.push_back(mKeys.add(key, 0));
+            });
+
+            build();
+        }
+
+        /**
+         *  @brief Indexes every key added so far, emptying the pending list.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the index. The previous index is kept.
+         *  @throw length_error Thrown when the keys produce more than 2^32 deletions.
+         */
+        void build(void)
+        {
+            // Counting the deletions up front avoids growing the array, which would double its peak size
+            size_t count = 0;
+            for (size_t key = 0; key < mOffsets.size(); key++)
+                count += countDeletions(min(mKeys.get(mOffsets[key]).size(), mPrefixLength));
+
+            if (count > UINT32_MAX)
+                throw length_error("FuzzyIndex has too many deletions");
+
+            vector<uint64_t> entries;
+            entries.reserve(count);
+
+            for (size_t key = 0; key < mOffsets.size(); key++)
+            {
+                string_view prefix = mKeys.get(mOffsets[key]).substr(0, mPrefixLength);
+                uint64_t number = key;
+
+                forEachDeletion(prefix, [&entries, number](const uint32_t &hash)
+                {
+                    entries.push_back((static_cast<uint64_t>(hash) << 32) | number);
+                });
+            }
+
+            sort(entries.begin(), entries.end());
+            entries.erase(unique(entries.begin(), entries.end()), entries.end());
+
+            // Aim for about DIRECTORY_LOAD entries behind each directory slot
+            uint32_t bits = 1;
+            while (bits < MAX_DIRECTORY_BITS && (static_cast<size_t>(DIRECTORY_LOAD) << bits) < entries.size())
+                ++bits;
+
+            vector<uint32_t> directory((static_cast<size_t>(1) << bits) + 1);
+            size_t entry = 0;
+            for (size_t slot = 0; slot < directory.size(); slot++)
+            {
+                while (entry < entries.size() && (entries[entry] >> (64 - bits)) < slot)
+                    ++entry;
+
+                directory[slot] = static_cast<uint32_t>(entry);
+            }
+
+            mEntries.swap(entries);
+            mDirectory.swap(directory);
+            mShift = 32 - bits;
+            mIndexedCount = mOffsets.size();
+            mBuilt = true;
+        }
+
+        /**
+         *  @brief Finds the keys within an edit distance of query.
+         *  @param query The string to find keys similar to.
+         *  @param maxDistance The largest edit distance to report. It is lowered to the
+         *  maxDistance the index was constructed with.
+         *  @return The keys found, closest first and alphabetically among equals.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the result.
+         */
+        vector<Match> search(string_view query, uint32_t maxDistance) const
+        {
+            if (maxDistance > mMaxDistance)
+                maxDistance = mMaxDistance;
+
+            vector<uint32_t> candidates;
+
+            forEachDeletion(query.substr(0, mPrefixLength), [this, &candidates](const uint32_t &hash)
+            {
+                const uint64_t *entry = lower_bound(mEntries.data() + mDirectory[hash >> mShift],
+                                                    mEntries.data() + mDirectory[(hash >> mShift) + 1],
+                                                    static_cast<uint64_t>(hash) << 32);
+                const uint64_t *end = mEntries.data() + mEntries.size();
+
+                for (; entry != end && (*entry >> 32) == hash; entry++)
+                    candidates.push_back(static_cast<uint32_t>(*entry));
+            });
+
+            sort(candidates.begin(), candidates.end());
+            candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+            for (size_t key = mIndexedCount; key < mOffsets.size(); key++)
+                candidates.push_back(static_cast<uint32_t>(key));
+
+            EditDistanceMatcher matcher(query);
+            vector<Match> result;
+
+            for (size_t index = 0; index < candidates.size(); index++)
+            {
+                Match match;
+                match.key = mKeys.get(mOffsets[candidates[index]]);
+                match.distance = matcher.measure(match.key, maxDistance);
+
+                if (match.distance <= maxDistance)
+                    result.push_back(match);
+            }
+
+            sort(result.begin(), result.end(), [](const Match &first, const Match &second)
+            {
+                return first.distance != second.distance ? first.distance < second.distance : first.key < second.key;
+            });
+
+            result.erase(unique(result.begin(), result.end(), [](const Match &first, const Match &second)
+            {
+                return first.key == second.key;
+            }), result.end());
+
+            return result;
+        }
+
+        /**
+         *  @brief Returns the number of keys added, counting repeats.
+         *  @return The number of keys.
+         */
+        size_t getSize(void) const
+        {
+            return mOffsets.size();
+        }
+
+        /**
+         *  @brief Returns the largest edit distance this FuzzyIndex can search for.
+         *  @return The maxDistance passed to the constructor.
+         */
+        uint32_t getMaxDistance(void) const
+        {
+            return mMaxDistance;
+        }
+
+        /**
+         *  @brief Returns the memory taken by the keys and the index.
+         *  @return The number of bytes allocated.
+         */
+        size_t getByteSize(void) const
+        {
+            return mKeys.getCapacity() + mOffsets.capacity() * sizeof(size_t) + mEntries.capacity() * sizeof(uint64_t)
+                   + mDirectory.capacity() * sizeof(uint32_t);
+        }
+
+    // Private Members
+    private:
+        //! The longest prefix deletions can be taken from, which bounds the buffers on the stack.
+        static constexpr size_t MAX_PREFIX_LENGTH = 32;
+        //! The fewest pending keys at which add() builds again.
+        static constexpr size_t MAX_PENDING_KEYS = 4096;
+        //! add() also waits until there is one pending key for every PENDING_FRACTION indexed ones.
+        static constexpr size_t PENDING_FRACTION = 8;
+        //! The number of entries the directory aims to have behind each of its slots.
+        static constexpr size_t DIRECTORY_LOAD = 4;
+        //! The most bits of the hash the directory uses.
+        static constexpr uint32_t MAX_DIRECTORY_BITS = 28;
+
+        //! The largest edit distance searched for.
+        uint32_t mMaxDistance;
+        //! The number of leading characters deletions are taken from.
+        size_t mPrefixLength;
+        //! The characters of the keys.
+        StringArena mKeys;
+        //! The offset in mKeys of every key, by key number.
+        vector<size_t> mOffsets;
+        //! The number of keys covered by mEntries. The rest are pending.
+        size_t mIndexedCount;
+        //! The hash of every deletion in the high half and its key number in the low half, sorted.
+        vector<uint64_t> mEntries;
+        //! For every value of the top bits of a hash, the first entry with at least that value.
+        vector<uint32_t> mDirectory;
+        //! The shift that leaves the directory bits of a 32 bit hash.
+        uint32_t mShift;
+        //! Whether or not build() has been called, after which add() builds again by itself.
+        bool mBuilt;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Returns how many deletions forEachDeletion() produces at most for a string.
+         *  @param length The length of the string.
+         *  @return The number of ways to delete up to mMaxDistance of its characters.
+         */
+        size_t countDeletions(const size_t &length) const
+        {
+            size_t result = 0;
+            size_t combinations = 1;
+
+            for (size_t deleted = 0; deleted <= mMaxDistance && deleted <= length; deleted++)
+            {
+                result += combinations;
+                combinations = combinations * (length - deleted) / (deleted + 1);
+            }
+
+            return result;
+        }
+
+        /**
+         *  @brief Calls functor with the hash of every distinct string obtained by deleting up to
+         *  mMaxDistance characters from value, value itself included.
+         *  @param value The string to delete from, at most MAX_PREFIX_LENGTH characters long.
+         *  @param functor A callable accepting a const uint32_t &.
+         */
+        template <typename functorType>
+        void forEachDeletion(string_view value, functorType functor) const
+        {
+            char buffer[MAX_PREFIX_LENGTH];
+            memcpy(buffer, value.data(), value.size());
+            deleteFrom(buffer, value.size(), 0, mMaxDistance, functor);
+        }
+
+        /**
+         *  @brief Reports a string and recursively every string obtained by deleting characters
+         *  from it at or after start.
+         *  @param buffer The characters of the string.
+         *  @param length The length of the string.
+         *  @param start The first position that may be deleted, which keeps every set of deleted
+         *  positions from being produced more than once.
+         *  @param remaining The number of characters that may still be deleted.
+         *  @param functor The callable to report hashes to.
+         */
+        template <typename functorType>
+        static void deleteFrom(const char *buffer, const size_t &length, const size_t &start, const uint32_t &remaining,
+                               functorType &functor)
+        {
+            uint64_t hash = WyHasher::hash(buffer, length);
+            functor(static_cast<uint32_t>(hash ^ (hash >> 32)));
+
+            if (!remaining)
+                return;
+
+            char shorter[MAX_PREFIX_LENGTH];
+            for (size_t position = start; position < length; position++)
+            {
+                // Deleting either of two equal neighbours gives the same string, and the first already covered it
+                if (position > start && buffer[position] == buffer[position - 1])
+                    continue;
+
+                memcpy(shorter, buffer, position);
+                memcpy(shorter + position, buffer + position + 1, length - position - 1);
+                deleteFrom(shorter, length - 1, position, remaining - 1, functor);
+            }
+        }
+};
+#endif // _INCLUDE_FUZZYINDEX_H_
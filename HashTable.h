@@ -0,0 +1,776 @@
+/**
+ *  @file HashTable.h
+ *  @brief Declaration for a generically typed, string keyed HashTable class.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_HASHTABLE_H_
+#define _INCLUDE_HASHTABLE_H_
+
+#include <new>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <string_view>
+#include <cstdlib>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+
+#include "Hashers.h"
+#include "RobinHood.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed HashTable mapping string keys to pointers of storedType.
+ *  @param storedType The type of the values to point to in our HashTable.
+ *  @param hasherType The hash function, a type with a static hash() accepting the characters and
+ *  length of a key and returning 64 bits. See Hashers.h.
+ *  @detail The HashTable is a single flat array of Buckets using open addressing with linear
+ *  probing and Robin Hood displacement: an inserted entry takes the place of any resident that
+ *  is closer to its home Bucket than the newcomer is, which keeps every probe sequence short.
+ *  Each Bucket stores the 32 bit hash of its key next to the key itself so a lookup only
+ *  compares strings whose hashes already match, and a lookup for an absent key stops as soon
+ *  as it reaches a Bucket closer to home than itself. Removal shifts the rest of the cluster
+ *  back by one instead of leaving tombstones behind.
+ *
+ *  Growing is incremental: the old Bucket array stays alive next to the new one and every
+ *  add() and find() moves at most MIGRATION_STEP of its Buckets across, so no single call pays
+ *  for rehashing the whole table. Lookups consult the new array first and then the part of the
+ *  old one that has not been migrated yet. Entries leaving the old array are marked as moved
+ *  rather than shifted, since the old array only ever shrinks until it is released. Bucket arrays
+ *  come from zeroed memory and keys are only constructed in Buckets that are in use, so even
+ *  allocating a huge new array costs nothing until its pages are first written.
+ *  @note The HashTable does not own the values it points to.
+ *  @note Because find() may migrate Buckets, concurrent calls to find() are only safe while
+ *  no migration is pending (see isMigrating() and completeMigration()).
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class HashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of Buckets to start with. It is rounded up to a
+         *  power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        HashTable(const size_t &initialCapacity = 16) : mOldBuckets(NULL), mOldCapacity(0), mMigrated(0), mSize(0)
+        {
+            mCapacity = MIN_CAPACITY;
+            while (mCapacity < initialCapacity)
+                mCapacity <<= 1;
+
+            mBuckets = allocateBuckets(mCapacity);
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~HashTable(void)
+        {
+            releaseBuckets(mBuckets, mCapacity);
+
+            if (mOldBuckets)
+                releaseBuckets(mOldBuckets, mOldCapacity);
+        }
+
+        HashTable(const HashTable<storedType, hasherType> &) = delete;
+        HashTable<storedType, hasherType>& operator =(const HashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the Bucket array.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            return addHashed(key, value, hashKey(key.data(), key.size()));
+        }
+
+        /**
+         *  @brief Associates value with key, using a hash the caller has already computed.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @param hash The hash of key as produced by hashKey().
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the Bucket array.
+         */
+        bool addHashed(string_view key, storedType *value, const uint32_t &hash)
+        {
+            migrate(MIGRATION_STEP);
+
+            Bucket *bucket = findBucket(key.data(), key.size(), hash);
+            if (bucket)
+            {
+                bucket->value = value;
+                return false;
+            }
+
+            if ((mSize + 1) * MAX_LOAD_DENOMINATOR > mCapacity * MAX_LOAD_NUMERATOR)
+                startMigration(mCapacity << 1);
+
+            // The key is copied before any Bucket moves, so a failed copy leaves the table as it was
+            string copy(key);
+
+            bucket = RobinHood::claim(mBuckets, mCapacity, hash, RelocateBucket());
+            new (bucket->keyStorage) string(std::move(copy));
+            bucket->value = value;
+
+            ++mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up. A string, string_view or C string may be passed without
+         *  copying it into a temporary string.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        storedType *find(string_view key) const
+        {
+            migrate(MIGRATION_STEP);
+            return findHashed(key, hashKey(key.data(), key.size()));
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this HashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key, using a hash the caller has already computed.
+         *  @param key The key to look up.
+         *  @param hash The hash of key as produced by hashKey().
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         *  @note Unlike find(), this never migrates Buckets, so any number of threads may call it
+         *  at once as long as nothing modifies the HashTable meanwhile.
+         */
+        storedType *findHashed(string_view key, const uint32_t &hash) const
+        {
+            Bucket *bucket = findBucket(key.data(), key.size(), hash);
+            return bucket ? bucket->value : NULL;
+        }
+
+        /**
+         *  @brief Looks up many keys at once, overlapping their cache misses. Keys are hashed and
+         *  their home Buckets prefetched BATCH_WINDOW keys ahead of being probed, so the memory
+         *  system fetches that many Buckets in parallel instead of every lookup waiting for its
+         *  miss before the next can start.
+         *  @param keys The keys to look up.
+         *  @param count The number of keys.
+         *  @param results Receives, for every key, a pointer to its value or NULL if it is not
+         *  present. It must have room for count pointers.
+         *  @return The number of keys that were present.
+         *  @note Like findHashed(), this never migrates Buckets, so any number of threads may call
+         *  it at once as long as nothing modifies the HashTable meanwhile.
+         */
+        size_t findBatch(const string_view *keys, const size_t &count, storedType **results) const
+        {
+            uint32_t hashes[BATCH_WINDOW];
+            size_t found = 0;
+
+            // Keep BATCH_WINDOW keys in flight: each probe is followed by the prefetch of a key further on
+            size_t ahead = count < BATCH_WINDOW ? count : BATCH_WINDOW;
+            for (size_t index = 0; index < ahead; index++)
+                hashes[index] = prefetchKey(keys[index]);
+
+            for (size_t index = 0; index < count; index++)
+            {
+                uint32_t hash = hashes[index % BATCH_WINDOW];
+
+                if (index + BATCH_WINDOW < count)
+                    hashes[index % BATCH_WINDOW] = prefetchKey(keys[index + BATCH_WINDOW]);
+
+                results[index] = findHashed(keys[index], hash);
+                if (results[index])
+                    ++found;
+            }
+
+            return found;
+        }
+
+        /**
+         *  @brief Removes key and its value from this HashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            return removeHashed(key, hashKey(key.data(), key.size()));
+        }
+
+        /**
+         *  @brief Removes key and its value, using a hash the caller has already computed.
+         *  @param key The key to remove.
+         *  @param hash The hash of key as produced by hashKey().
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool removeHashed(string_view key, const uint32_t &hash)
+        {
+            Bucket *bucket = findBucket(key.data(), key.size(), hash);
+
+            if (!bucket)
+                return false;
+
+            // Not yet migrated Buckets are just marked as moved; the old array never shifts
+            if (bucket < mBuckets || bucket >= mBuckets + mCapacity)
+            {
+                destroyKey(*bucket);
+                bucket->value = NULL;
+                bucket->distance |= MOVED;
+
+                --mSize;
+                return true;
+            }
+
+            destroyKey(*bucket);
+            RobinHood::erase(mBuckets, mCapacity, bucket, RelocateBucket());
+
+            --mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Hashes a key with hasherType, folded down to the 32 bits the Buckets keep.
+         *  @param key A pointer to the characters of the key.
+         *  @param length The number of characters in the key.
+         *  @return The hash of the key.
+         *  @note The low bits of the hash select the home Bucket, so callers layering tables on
+         *  top of HashTable should partition by the high bits.
+         */
+        static uint32_t hashKey(const char *key, const size_t &length)
+        {
+            return foldHash(hasherType::hash(key, length));
+        }
+
+        /**
+         *  @brief Folds a 64 bit hash from hasherType down to the 32 bits the Buckets keep, for
+         *  callers that need the full hash of a key as well.
+         *  @param hash The 64 bit hash of a key.
+         *  @return The same value hashKey() returns for that key.
+         */
+        static uint32_t foldHash(const uint64_t &hash)
+        {
+            return static_cast<uint32_t>(hash ^ (hash >> 32));
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this HashTable.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note The HashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t index = 0; index < mCapacity; index++)
+                if (mBuckets[index].distance)
+                    functor(mBuckets[index].getKey(), mBuckets[index].value);
+
+            for (size_t index = mMigrated; index < mOldCapacity; index++)
+                if (isLive(mOldBuckets[index]))
+                    functor(mOldBuckets[index].getKey(), mOldBuckets[index].value);
+        }
+
+        /**
+         *  @brief Moves every remaining Bucket of a pending migration into the new array and
+         *  releases the old one.
+         */
+        void completeMigration(void)
+        {
+            migrate(mOldCapacity);
+        }
+
+        /**
+         *  @brief Grows the HashTable up front so that it can hold count keys without growing
+         *  again. Existing entries are moved across immediately rather than incrementally.
+         *  @param count The number of keys to make room for.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        void reserve(const size_t &count)
+        {
+            size_t capacity = mCapacity;
+            while (count * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR)
+                capacity <<= 1;
+
+            if (capacity == mCapacity)
+                return;
+
+            startMigration(capacity);
+            completeMigration();
+        }
+
+        /**
+         *  @brief A summary of the state of a HashTable, for spotting a table that degrades.
+         */
+        struct Statistics
+        {
+            //! The number of keys stored.
+            size_t size;
+            //! The number of Buckets in the current array.
+            size_t capacity;
+            //! size divided by capacity.
+            double loadFactor;
+            //! Whether or not an old Bucket array is still being migrated.
+            bool migrating;
+            //! The number of Buckets of the old array that have been migrated so far.
+            size_t migratedBuckets;
+            //! The number of Buckets of the old array, or zero when not migrating.
+            size_t migrationBuckets;
+            //! The fraction of the old array migrated so far, 1 when not migrating.
+            double migrationProgress;
+            //! For every probe length, the number of keys a lookup finds after probing that many
+            //! Buckets of their array. Index 0 is unused; 1 means found in the home Bucket.
+            vector<size_t> probeLengths;
+            //! The longest probe length of any key, which is one more than its displacement.
+            size_t maxProbeLength;
+            //! The average probe length of a lookup for a present key.
+            double meanProbeLength;
+            //! The Buckets of the old array that are marked as moved but not yet migrated past.
+            //! Lookups step over them like tombstones. The current array never has any.
+            size_t movedBuckets;
+            //! The bytes taken by the Bucket arrays, old array included.
+            size_t bucketBytes;
+            //! The heap bytes taken by keys too long to be stored inside their Bucket.
+            size_t keyBytes;
+            //! The bytes of the values pointed to. The HashTable does not own them, so they are
+            //! not part of totalBytes.
+            size_t valueBytes;
+            //! bucketBytes plus keyBytes.
+            size_t totalBytes;
+
+            /**
+             *  @brief Formats the Statistics as a JSON object.
+             *  @return The JSON text, on one line.
+             */
+            string toJSON(void) const
+            {
+                ostringstream stream;
+
+                stream << "{\"size\":" << size << ",\"capacity\":" << capacity << ",\"loadFactor\":" << loadFactor
+                       << ",\"migrating\":" << (migrating ? "true" : "false") << ",\"migratedBuckets\":" << migratedBuckets
+                       << ",\"migrationBuckets\":" << migrationBuckets << ",\"migrationProgress\":" << migrationProgress
+                       << ",\"probeLengths\":[";
+
+                for (size_t length = 1; length < probeLengths.size(); length++)
+                    stream << (length > 1 ? "," : "") << probeLengths[length];
+
+                stream << "],\"maxProbeLength\":" << maxProbeLength << ",\"meanProbeLength\":" << meanProbeLength
+                       << ",\"movedBuckets\":" << movedBuckets << ",\"bucketBytes\":" << bucketBytes
+                       << ",\"keyBytes\":" << keyBytes << ",\"valueBytes\":" << valueBytes
+                       << ",\"totalBytes\":" << totalBytes << "}";
+
+                return stream.str();
+            }
+        };
+
+        /**
+         *  @brief Returns a summary of the state of this HashTable.
+         *  @return The Statistics of this HashTable.
+         *  @note This walks every Bucket. isMigrating() answers the one question that needs to
+         *  be cheap.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the probe length histogram.
+         */
+        Statistics getStatistics(void) const
+        {
+            Statistics result;
+
+            result.size = mSize;
+            result.capacity = mCapacity;
+            result.loadFactor = static_cast<double>(mSize) / mCapacity;
+            result.migrating = mOldBuckets != NULL;
+            result.migratedBuckets = mMigrated;
+            result.migrationBuckets = mOldCapacity;
+            result.migrationProgress = mOldCapacity ? static_cast<double>(mMigrated) / mOldCapacity : 1.0;
+            result.maxProbeLength = 0;
+            result.movedBuckets = 0;
+            result.keyBytes = 0;
+
+            size_t probeTotal = 0;
+            inspectBuckets(mBuckets, 0, mCapacity, result, probeTotal);
+            inspectBuckets(mOldBuckets, mMigrated, mOldCapacity, result, probeTotal);
+
+            result.meanProbeLength = mSize ? static_cast<double>(probeTotal) / mSize : 0.0;
+            result.bucketBytes = (mCapacity + mOldCapacity) * sizeof(Bucket);
+            result.valueBytes = mSize * sizeof(storedType);
+            result.totalBytes = result.bucketBytes + result.keyBytes;
+
+            return result;
+        }
+
+        /**
+         *  @brief Returns whether or not an old Bucket array is still being migrated.
+         *  @return A boolean representing whether or not a migration is pending.
+         */
+        bool isMigrating(void) const
+        {
+            return mOldBuckets != NULL;
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this HashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns the number of Buckets in this HashTable.
+         *  @return The current capacity.
+         */
+        size_t getCapacity(void) const
+        {
+            return mCapacity;
+        }
+
+        /**
+         *  @brief Returns whether or not this HashTable is empty.
+         *  @return A boolean representing whether or not this HashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a HashTable into a stream. Every value
+         *  is written on its own line, in Bucket order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The HashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const HashTable<storedType, hasherType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](const string &, storedType *value)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << *value;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A slot of the HashTable. It is empty when distance is zero. An all zero Bucket is a
+         *  valid empty Bucket, which is what lets Bucket arrays come straight from calloc().
+         */
+        struct Bucket
+        {
+            //! Returns the key stored in this Bucket. Only valid while the Bucket is live.
+            string &getKey(void)
+            {
+                return *std::launder(reinterpret_cast<string *>(keyStorage));
+            }
+
+            //! Returns the key stored in this Bucket. Only valid while the Bucket is live.
+            const string &getKey(void) const
+            {
+                return *std::launder(reinterpret_cast<const string *>(keyStorage));
+            }
+
+            //! A pointer to the value stored for the key.
+            storedType *value;
+            //! The hash of the key. Its low bits select the home Bucket.
+            uint32_t hash;
+            //! One more than the distance from the home Bucket. Zero if this Bucket is empty.
+            //! Buckets of the old array that have been migrated or removed also carry MOVED.
+            uint32_t distance;
+            //! Storage for the key, which is only constructed while the Bucket is live.
+            alignas(string) unsigned char keyStorage[sizeof(string)];
+        };
+
+        /**
+         *  Moves the key, value and hash of a live Bucket into an empty one, for RobinHood.
+         */
+        struct RelocateBucket
+        {
+            /**
+             *  @brief Moves the contents of one Bucket into another.
+             *  @param target The empty Bucket to move into.
+             *  @param source The live Bucket to move out of. Its key is destroyed.
+             */
+            void operator ()(Bucket &target, Bucket &source) const
+            {
+                new (target.keyStorage) string(std::move(source.getKey()));
+                destroyKey(source);
+                target.value = source.value;
+                target.hash = source.hash;
+            }
+        };
+
+        //! The smallest capacity the HashTable will use.
+        static constexpr size_t MIN_CAPACITY = 8;
+        //! The HashTable grows once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+        //! The HashTable grows once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_DENOMINATOR = 8;
+        //! The number of old Buckets each add() and find() migrates while growing.
+        static constexpr size_t MIGRATION_STEP = 8;
+        //! Marks an old Bucket whose entry has left. It keeps probes going like a tombstone would.
+        static constexpr uint32_t MOVED = 0x80000000U;
+        //! The number of keys findBatch() hashes and prefetches ahead of the one it probes.
+        static constexpr size_t BATCH_WINDOW = 16;
+
+        //! The Bucket array new entries go into.
+        Bucket *mBuckets;
+        //! The number of Buckets. Always a power of two.
+        size_t mCapacity;
+        //! The Bucket array being migrated away from. NULL when not growing.
+        mutable Bucket *mOldBuckets;
+        //! The number of Buckets in the old array. Zero when not growing.
+        mutable size_t mOldCapacity;
+        //! The number of Buckets at the front of the old array that have been migrated.
+        mutable size_t mMigrated;
+        //! The number of keys stored.
+        size_t mSize;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Returns whether or not a Bucket holds an entry.
+         *  @param bucket The Bucket to check.
+         *  @return A boolean representing whether or not the Bucket is neither empty nor moved.
+         */
+        static bool isLive(const Bucket &bucket)
+        {
+            return bucket.distance && !(bucket.distance & MOVED);
+        }
+
+        /**
+         *  @brief Asks the processor to start loading the cache line holding address.
+         *  @param address The address that is about to be read.
+         */
+        static void prefetch(const void *address)
+        {
+#ifdef __GNUC__
+            __builtin_prefetch(address);
+#else
+            (void)address;
+#endif
+        }
+
+        /**
+         *  @brief Hashes a key and prefetches its home Buckets, for findBatch().
+         *  @param key The key about to be looked up.
+         *  @return The hash of key.
+         */
+        uint32_t prefetchKey(const string_view &key) const
+        {
+            uint32_t hash = hashKey(key.data(), key.size());
+            prefetch(&mBuckets[hash & (mCapacity - 1)]);
+
+            // Keys homed in the part of the old array not yet migrated may only be found there
+            if (mOldBuckets && (hash & (mOldCapacity - 1)) >= mMigrated)
+                prefetch(&mOldBuckets[hash & (mOldCapacity - 1)]);
+
+            return hash;
+        }
+
+        /**
+         *  @brief Adds the probe lengths, moved Buckets and key bytes of part of a Bucket array
+         *  to a Statistics.
+         *  @param buckets The Bucket array. May be NULL.
+         *  @param first The first Bucket to look at.
+         *  @param capacity The number of Buckets in the array.
+         *  @param result The Statistics to add to.
+         *  @param probeTotal The sum of the probe lengths, which is added to.
+         */
+        static void inspectBuckets(const Bucket *buckets, const size_t &first, const size_t &capacity,
+                                   Statistics &result, size_t &probeTotal)
+        {
+            for (size_t index = first; buckets && index < capacity; index++)
+            {
+                const Bucket &bucket = buckets[index];
+
+                if (bucket.distance & MOVED)
+                {
+                    ++result.movedBuckets;
+                    continue;
+                }
+
+                if (!bucket.distance)
+                    continue;
+
+                size_t length = bucket.distance;
+                if (result.probeLengths.size() <= length)
+                    result.probeLengths.resize(length + 1);
+
+                ++result.probeLengths[length];
+                probeTotal += length;
+                if (length > result.maxProbeLength)
+                    result.maxProbeLength = length;
+
+                // Short keys live inside the string object itself, in the Bucket
+                const string &key = bucket.getKey();
+                uintptr_t data = reinterpret_cast<uintptr_t>(key.data());
+                uintptr_t storage = reinterpret_cast<uintptr_t>(bucket.keyStorage);
+                if (data < storage || data >= storage + sizeof(bucket.keyStorage))
+                    result.keyBytes += key.capacity() + 1;
+            }
+        }
+
+        /**
+         *  @brief Finds the Bucket holding a key in one Bucket array.
+         *  @param buckets The Bucket array to search.
+         *  @param capacity The number of Buckets in the array.
+         *  @param key A pointer to the characters of the key.
+         *  @param length The number of characters in the key.
+         *  @param hash The hash of the key.
+         *  @return A pointer to the Bucket holding the key, or NULL if it is not in this array.
+         */
+        static Bucket *probe(Bucket *buckets, const size_t &capacity, const char *key, const size_t &length,
+                             const uint32_t &hash)
+        {
+            // Moved Buckets compare as far from home, so the probe steps over them
+            return RobinHood::probe(buckets, capacity, hash, [key, &length](const Bucket &bucket)
+            {
+                return !(bucket.distance & MOVED) && bucket.getKey().size() == length &&
+                       !bucket.getKey().compare(0, length, key, length);
+            });
+        }
+
+        /**
+         *  @brief Finds the Bucket holding a key, looking in the old array too while growing.
+         *  @param key A pointer to the characters of the key.
+         *  @param length The number of characters in the key.
+         *  @param hash The hash of the key.
+         *  @return A pointer to the Bucket holding the key, or NULL if it is not present.
+         */
+        Bucket *findBucket(const char *key, const size_t &length, const uint32_t &hash) const
+        {
+            Bucket *result = probe(mBuckets, mCapacity, key, length, hash);
+
+            if (!result && mOldBuckets)
+                result = probe(mOldBuckets, mOldCapacity, key, length, hash);
+
+            return result;
+        }
+
+        /**
+         *  @brief Allocates an array of empty Buckets.
+         *  @param capacity The number of Buckets to allocate.
+         *  @return A pointer to the first Bucket.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         *  @note Large zeroed blocks are mapped lazily by the operating system, so this does not
+         *  touch the memory it returns.
+         */
+        static Bucket *allocateBuckets(const size_t &capacity)
+        {
+            void *memory = calloc(capacity, sizeof(Bucket));
+
+            if (!memory)
+                throw bad_alloc();
+
+            return static_cast<Bucket *>(memory);
+        }
+
+        /**
+         *  @brief Destroys the keys of every live Bucket of an array and frees the array.
+         *  @param buckets The Bucket array to release.
+         *  @param capacity The number of Buckets in the array.
+         */
+        static void releaseBuckets(Bucket *buckets, const size_t &capacity)
+        {
+            for (size_t index = 0; index < capacity; index++)
+                if (isLive(buckets[index]))
+                    destroyKey(buckets[index]);
+
+            free(buckets);
+        }
+
+        /**
+         *  @brief Destroys the key of a live Bucket. The caller updates distance afterwards.
+         *  @param bucket The Bucket whose key to destroy.
+         */
+        static void destroyKey(Bucket &bucket)
+        {
+            bucket.getKey().~string();
+        }
+
+        /**
+         *  @brief Switches to a new, larger Bucket array, keeping the current one around to be
+         *  migrated incrementally. A migration that is still pending is finished first.
+         *  @param capacity The new capacity. Must be a power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Bucket array.
+         */
+        void startMigration(const size_t &capacity)
+        {
+            completeMigration();
+
+            Bucket *buckets = allocateBuckets(capacity);
+
+            mOldBuckets = mBuckets;
+            mOldCapacity = mCapacity;
+            mMigrated = 0;
+
+            mBuckets = buckets;
+            mCapacity = capacity;
+        }
+
+        /**
+         *  @brief Moves up to count Buckets of the old array into the new one, releasing the
+         *  old array once it has been fully migrated.
+         *  @param count The maximum number of old Buckets to visit.
+         *  @note This is const because find() drives migration. It only reorganizes storage and
+         *  never changes which entries the HashTable holds.
+         */
+        void migrate(const size_t &count) const
+        {
+            if (!mOldBuckets)
+                return;
+
+            size_t end = mOldCapacity - mMigrated > count ? mMigrated + count : mOldCapacity;
+
+            for (; mMigrated < end; mMigrated++)
+            {
+                Bucket &bucket = mOldBuckets[mMigrated];
+
+                // Empty Buckets stay empty so that probes of the old array still end at them
+                if (isLive(bucket))
+                {
+                    RelocateBucket()(*RobinHood::claim(mBuckets, mCapacity, bucket.hash, RelocateBucket()), bucket);
+                    bucket.distance |= MOVED;
+                }
+            }
+
+            // Every key has left by now, so there is nothing to destroy
+            if (mMigrated == mOldCapacity)
+            {
+                free(mOldBuckets);
+
+                mOldBuckets = NULL;
+                mOldCapacity = 0;
+                mMigrated = 0;
+            }
+        }
+};
+#endif // _INCLUDE_HASHTABLE_H_
@@ -0,0 +1,191 @@
+/**
+ *  @file Hashers.h
+ *  @brief Declaration for the string hash functions the HashTable implementations can be
+ *  parameterized with.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_HASHERS_H_
+#define _INCLUDE_HASHERS_H_
+
+#include <cstring>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ *  @brief 64 bit FNV-1a. One multiply per byte makes it quick for very short keys and slow for
+ *  long ones, and since each byte only reaches the high bits through later multiplies, keys that
+ *  differ in their last character differ mostly in the low bits.
+ */
+struct FNV1aHasher
+{
+    /**
+     *  @brief Hashes a string.
+     *  @param key A pointer to the characters of the string.
+     *  @param length The number of characters in the string.
+     *  @return The 64 bit hash.
+     *  @note This is constexpr, so tables built at compile time can use it.
+     */
+    static constexpr uint64_t hash(const char *key, const size_t &length)
+    {
+        uint64_t result = 14695981039346656037ULL;
+
+        for (size_t iteration = 0; iteration < length; iteration++)
+        {
+            result ^= static_cast<unsigned char>(key[iteration]);
+            result *= 1099511628211ULL;
+        }
+
+        return result;
+    }
+};
+
+/**
+ *  @brief A 64 bit hash after wyhash, which consumes its input eight or sixteen bytes at a time
+ *  and mixes with full 64 by 64 to 128 bit multiplies, so every output bit depends on every
+ *  input bit even for the shortest keys. Keys of up to sixteen bytes, which covers most words,
+ *  are read with a fixed handful of possibly overlapping loads and no loop at all.
+ *  @note Words are read in native byte order, so the values differ between little and big
+ *  endian machines. They are meant for in-memory tables, not for storage.
+ */
+struct WyHasher
+{
+    /**
+     *  @brief Hashes a string.
+     *  @param key A pointer to the characters of the string.
+     *  @param length The number of characters in the string.
+     *  @return The 64 bit hash.
+     */
+    static uint64_t hash(const char *key, const size_t &length)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(key);
+        uint64_t seed = mix(SECRET[0], SECRET[1]);
+        uint64_t first, second;
+
+        if (length <= 16)
+        {
+            if (length >= 4)
+            {
+                // Two pairs of overlapping 32 bit reads cover anything from four to sixteen bytes
+                size_t middle = (length >> 3) << 2;
+                first = (read32(bytes) << 32) | read32(bytes + middle);
+                second = (read32(bytes + length - 4) << 32) | read32(bytes + length - 4 - middle);
+            }
+            else if (length)
+            {
+                first = (static_cast<uint64_t>(bytes[0]) << 16) | (static_cast<uint64_t>(bytes[length >> 1]) << 8) |
+                        bytes[length - 1];
+                second = 0;
+            }
+            else
+                first = second = 0;
+        }
+        else
+        {
+            size_t remaining = length;
+
+            if (remaining > 48)
+            {
+                uint64_t lane1 = seed, lane2 = seed;
+
+                do
+                {
+                    seed = mix(read64(bytes) ^ SECRET[1], read64(bytes + 8) ^ seed);
+                    lane1 = mix(read64(bytes + 16) ^ SECRET[2], read64(bytes + 24) ^ lane1);
+                    lane2 = mix(read64(bytes + 32) ^ SECRET[3], read64(bytes + 40) ^ lane2);
+                    bytes += 48;
+                    remaining -= 48;
+                }
+                while (remaining > 48);
+
+                seed ^= lane1 ^ lane2;
+            }
+
+            while (remaining > 16)
+            {
+                seed = mix(read64(bytes) ^ SECRET[1], read64(bytes + 8) ^ seed);
+                bytes += 16;
+                remaining -= 16;
+            }
+
+            // The last sixteen bytes are read whole, overlapping what the loop already consumed
+            first = read64(bytes + remaining - 16);
+            second = read64(bytes + remaining - 8);
+        }
+
+        first ^= SECRET[1];
+        second ^= seed;
+        multiply(first, second);
+
+        return mix(first ^ SECRET[0] ^ length, second ^ SECRET[1]);
+    }
+
+    // Private Members
+    private:
+        //! Odd constants with balanced bits that every input word is combined with.
+        static constexpr uint64_t SECRET[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+                                                0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Multiplies two 64 bit numbers into a 128 bit product.
+         *  @param low Multiplied, then assigned the low half of the product.
+         *  @param high Multiplied, then assigned the high half of the product.
+         */
+        static void multiply(uint64_t &low, uint64_t &high)
+        {
+#ifdef __SIZEOF_INT128__
+            unsigned __int128 product = static_cast<unsigned __int128>(low) * high;
+            low = static_cast<uint64_t>(product);
+            high = static_cast<uint64_t>(product >> 64);
+#else
+            uint64_t lowLow = (low & 0xFFFFFFFFULL) * (high & 0xFFFFFFFFULL);
+            uint64_t lowHigh = (low & 0xFFFFFFFFULL) * (high >> 32);
+            uint64_t highLow = (low >> 32) * (high & 0xFFFFFFFFULL);
+            uint64_t highHigh = (low >> 32) * (high >> 32);
+            uint64_t cross = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFULL) + (highLow & 0xFFFFFFFFULL);
+
+            low = (cross << 32) | (lowLow & 0xFFFFFFFFULL);
+            high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (cross >> 32);
+#endif
+        }
+
+        /**
+         *  @brief Folds the 128 bit product of two numbers back into 64 bits.
+         *  @param first The first factor.
+         *  @param second The second factor.
+         *  @return The low and high halves of the product, combined.
+         */
+        static uint64_t mix(uint64_t first, uint64_t second)
+        {
+            multiply(first, second);
+            return first ^ second;
+        }
+
+        /**
+         *  @brief Reads eight bytes as a number, without any alignment requirement.
+         *  @param bytes A pointer to the bytes.
+         *  @return The number.
+         */
+        static uint64_t read64(const unsigned char *bytes)
+        {
+            uint64_t result;
+            memcpy(&result, bytes, sizeof(result));
+            return result;
+        }
+
+        /**
+         *  @brief Reads four bytes as a number, without any alignment requirement.
+         *  @param bytes A pointer to the bytes.
+         *  @return The number.
+         */
+        static uint64_t read32(const unsigned char *bytes)
+        {
+            uint32_t result;
+            memcpy(&result, bytes, sizeof(result));
+            return result;
+        }
+};
+#endif // _INCLUDE_HASHERS_H_
@@ -0,0 +1,474 @@
+/**
+ *  @file IndexedHashTable.h
+ *  @brief Declaration for a KeyedHashTable that also maintains secondary indexes on other fields
+ *  of its records.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_INDEXEDHASHTABLE_H_
+#define _INCLUDE_INDEXEDHASHTABLE_H_
+
+#include <set>
+#include <tuple>
+#include <string>
+#include <utility>
+#include <iostream>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "KeyedHashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief A field extractor reading a member of a record, for declaring secondary indexes.
+ *  @param recordType The type of the record.
+ *  @param fieldType The type of the member.
+ *  @param member A pointer to the member.
+ */
+template <typename recordType, typename fieldType, fieldType recordType::*member>
+struct MemberField
+{
+    //! The type of the records the field is read from.
+    typedef recordType record;
+    //! The type of the field.
+    typedef fieldType field;
+
+    /**
+     *  @brief Returns the field of a record.
+     *  @param value The record to read the field of.
+     *  @return A reference to the member.
+     */
+    const fieldType &operator ()(const recordType &value) const
+    {
+        return value.*member;
+    }
+};
+
+/**
+ *  @brief A secondary index answering equality queries on one field, for use with
+ *  IndexedHashTable.
+ *  @param fieldExtractor A field extractor such as MemberField. The field type needs std::hash
+ *  and operator ==.
+ *  @detail Every distinct field value maps to the set of records holding it, so finding the
+ *  records with a value costs one hash lookup plus the records reported, and so does removing a
+ *  record however many others share its value.
+ */
+template <typename fieldExtractor>
+class HashIndex
+{
+    // Public Methods
+    public:
+        //! The type of the records indexed.
+        typedef typename fieldExtractor::record record;
+        //! The type of the indexed field.
+        typedef typename fieldExtractor::field field;
+
+        /**
+         *  @brief Calls functor with every record whose field equals value, in no particular order.
+         *  @param value The field value to look for.
+         *  @param functor A callable accepting a record *.
+         *  @return The number of records reported.
+         */
+        template <typename functorType>
+        size_t forEach(const field &value, functorType functor) const
+        {
+            typename unordered_map<field, unordered_set<record *> >::const_iterator entry = mRecords.find(value);
+            if (entry == mRecords.end())
+                return 0;
+
+            for (record *current : entry->second)
+                functor(current);
+
+            return entry->second.size();
+        }
+
+        /**
+         *  @brief Returns the number of records whose field equals value.
+         *  @param value The field value to look for.
+         *  @return The number of records with that value.
+         */
+        size_t count(const field &value) const
+        {
+            typename unordered_map<field, unordered_set<record *> >::const_iterator entry = mRecords.find(value);
+            return entry == mRecords.end() ? 0 : entry->second.size();
+        }
+
+        /**
+         *  @brief Returns the number of distinct field values indexed.
+         *  @return The number of distinct values.
+         */
+        size_t getDistinctCount(void) const
+        {
+            return mRecords.size();
+        }
+
+    // Private Members
+    private:
+        template <typename, typename, typename...> friend class IndexedHashTable;
+
+        //! Reads the field of a record.
+        fieldExtractor mExtractor;
+        //! The records holding every field value.
+        unordered_map<field, unordered_set<record *> > mRecords;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Adds a record to the index.
+         *  @param value The record to add.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap. The index is unchanged.
+         */
+        void insert(record *value)
+        {
+            unordered_set<record *> &records = mRecords[mExtractor(*value)];
+
+            try
+            {
+                records.insert(value);
+            }
+            catch (...)
+            {
+                if (records.empty())
+                    mRecords.erase(mExtractor(*value));
+
+                throw;
+            }
+        }
+
+        /**
+         *  @brief Removes a record from the index, if it is there.
+         *  @param value The record to remove.
+         */
+        void erase(record *value)
+        {
+            typename unordered_map<field, unordered_set<record *> >::iterator entry = mRecords.find(mExtractor(*value));
+            if (entry == mRecords.end())
+                return;
+
+            entry->second.erase(value);
+            if (entry->second.empty())
+                mRecords.erase(entry);
+        }
+};
+
+/**
+ *  @brief A secondary index answering equality and range queries on one field, for use with
+ *  IndexedHashTable.
+ *  @param fieldExtractor A field extractor such as MemberField. The field type needs operator <.
+ *  @detail Records are kept in a balanced tree ordered by field value and then by address, so
+ *  records with equal values are distinct entries. A range query costs one descent plus the
+ *  records reported, and they come out in order of their field.
+ */
+template <typename fieldExtractor>
+class SortedIndex
+{
+    // Public Methods
+    public:
+        //! The type of the records indexed.
+        typedef typename fieldExtractor::record record;
+        //! The type of the indexed field.
+        typedef typename fieldExtractor::field field;
+
+        /**
+         *  @brief Calls functor with every record whose field is between low and high inclusive,
+         *  in ascending order of the field.
+         *  @param low The smallest field value to report.
+         *  @param high The largest field value to report.
+         *  @param functor A callable accepting a record *.
+         *  @return The number of records reported.
+         */
+        template <typename functorType>
+        size_t forEachInRange(const field &low, const field &high, functorType functor) const
+        {
+            size_t result = 0;
+
+            for (typename set<Entry>::const_iterator entry = mRecords.lower_bound(Entry(low, NULL));
+                 entry != mRecords.end() && !(high < entry->first); ++entry)
+            {
+                functor(entry->second);
+                ++result;
+            }
+
+            return result;
+        }
+
+        /**
+         *  @brief Calls functor with every record whose field equals value.
+         *  @param value The field value to look for.
+         *  @param functor A callable accepting a record *.
+         *  @return The number of records reported.
+         */
+        template <typename functorType>
+        size_t forEach(const field &value, functorType functor) const
+        {
+            return forEachInRange(value, value, functor);
+        }
+
+        /**
+         *  @brief Returns the record with the smallest field value.
+         *  @return A pointer to the record, or NULL if the index is empty.
+         */
+        record *getFirst(void) const
+        {
+            return mRecords.empty() ? NULL : mRecords.begin()->second;
+        }
+
+        /**
+         *  @brief Returns the record with the largest field value.
+         *  @return A pointer to the record, or NULL if the index is empty.
+         */
+        record *getLast(void) const
+        {
+            return mRecords.empty() ? NULL : mRecords.rbegin()->second;
+        }
+
+    // Private Members
+    private:
+        template <typename, typename, typename...> friend class IndexedHashTable;
+
+        /**
+         *  An entry of the tree, a field value and a record holding it.
+         */
+        typedef pair<field, record *> Entry;
+
+        /**
+         *  Orders Entries by field value and then by record address.
+         */
+        struct EntryOrder
+        {
+            /**
+             *  @brief Compares two Entries.
+             *  @param first The first Entry.
+             *  @param second The second Entry.
+             *  @return A boolean representing whether or not first comes before second.
+             */
+            bool operator ()(const Entry &first, const Entry &second) const
+            {
+                if (first.first < second.first)
+                    return true;
+
+                if (second.first < first.first)
+                    return false;
+
+                return less<record *>()(first.second, second.second);
+            }
+        };
+
+        //! Reads the field of a record.
+        fieldExtractor mExtractor;
+        //! The records, ordered by field.
+        set<Entry, EntryOrder> mRecords;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Adds a record to the index.
+         *  @param value The record to add.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap. The index is unchanged.
+         */
+        void insert(record *value)
+        {
+            mRecords.insert(Entry(mExtractor(*value), value));
+        }
+
+        /**
+         *  @brief Removes a record from the index, if it is there.
+         *  @param value The record to remove.
+         */
+        void erase(record *value)
+        {
+            mRecords.erase(Entry(mExtractor(*value), value));
+        }
+};
+
+/**
+ *  @brief A KeyedHashTable of pointers to storedType that keeps any number of secondary indexes
+ *  on other fields of the records up to date as records are added and removed.
+ *  @param storedType The type of the records to point to in our IndexedHashTable.
+ *  @param keyExtractor The extractor of the primary key, as for KeyedHashTable.
+ *  @param indexTypes The secondary indexes, such as HashIndex and SortedIndex, each over a field
+ *  of storedType.
+ *  @detail Lookups by primary key go to the KeyedHashTable. Queries on other fields go to the
+ *  index declared for them, which getIndex() returns by position, so a query that would scan
+ *  every record becomes an index lookup that only visits the records it reports.
+ *  @note The IndexedHashTable does not own the records it points to. Neither the key nor any
+ *  indexed field of a record may change while the record is in the IndexedHashTable; remove it,
+ *  change it and add it again instead.
+ */
+template <typename storedType, typename keyExtractor, typename... indexTypes>
+class IndexedHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of Buckets of the primary table to start with.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        IndexedHashTable(const size_t &initialCapacity = 16) : mTable(initialCapacity)
+        {
+
+        }
+
+        IndexedHashTable(const IndexedHashTable<storedType, keyExtractor, indexTypes...> &) = delete;
+        IndexedHashTable<storedType, keyExtractor, indexTypes...>& operator =(const IndexedHashTable<storedType, keyExtractor, indexTypes...> &) = delete;
+
+        /**
+         *  @brief Adds a record under its own key and to every index, replacing any record
+         *  already stored with an equal key.
+         *  @param value A pointer to the record to store.
+         *  @return A boolean representing whether or not the key of value was newly added.
+         *  @retval false Returned if the key was already present and its record has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the table or an index. The IndexedHashTable is unchanged.
+         */
+        bool add(storedType *value)
+        {
+            storedType *previous = mTable.find(mExtractor(*value));
+            if (previous == value)
+                return false;
+
+            // The indexes take the record first, since taking it out of them again cannot fail
+            try
+            {
+                apply([value](indexTypes &... indexes) { (indexes.insert(value), ...); }, mIndexes);
+                mTable.add(value);
+            }
+            catch (...)
+            {
+                eraseFromIndexes(value);
+                throw;
+            }
+
+            if (previous)
+                eraseFromIndexes(previous);
+
+            return previous == NULL;
+        }
+
+        /**
+         *  @brief Looks up the record whose key equals key.
+         *  @param key The key to look up.
+         *  @return A pointer to the record with that key, or NULL if there is none.
+         */
+        storedType *find(string_view key) const
+        {
+            return mTable.find(key);
+        }
+
+        /**
+         *  @brief Returns whether or not a record with key is present in this IndexedHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return mTable.contains(key);
+        }
+
+        /**
+         *  @brief Removes the record whose key equals key from the table and every index.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            storedType *value = mTable.find(key);
+
+            if (!value)
+                return false;
+
+            eraseFromIndexes(value);
+            mTable.remove(key);
+            return true;
+        }
+
+        /**
+         *  @brief Returns a secondary index to query.
+         *  @param number The position of the index in indexTypes.
+         *  @return A reference to the index.
+         */
+        template <size_t number>
+        const typename tuple_element<number, tuple<indexTypes...> >::type &getIndex(void) const
+        {
+            return get<number>(mIndexes);
+        }
+
+        /**
+         *  @brief Calls functor with every record in this IndexedHashTable.
+         *  @param functor A callable accepting a storedType *.
+         *  @note The IndexedHashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            mTable.forEach(functor);
+        }
+
+        /**
+         *  @brief Returns the number of records stored in this IndexedHashTable.
+         *  @return The number of records currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mTable.getSize();
+        }
+
+        /**
+         *  @brief Returns the number of Buckets of the primary table.
+         *  @return The current capacity.
+         */
+        size_t getCapacity(void) const
+        {
+            return mTable.getCapacity();
+        }
+
+        /**
+         *  @brief Returns whether or not this IndexedHashTable is empty.
+         *  @return A boolean representing whether or not this IndexedHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mTable.isEmpty();
+        }
+
+        /**
+         *  @brief Stream insertion operator to put an IndexedHashTable into a stream. Every
+         *  record is written on its own line, in Bucket order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The IndexedHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const IndexedHashTable<storedType, keyExtractor, indexTypes...> &input)
+        {
+            return stream << input.mTable;
+        }
+
+    // Private Members
+    private:
+        //! Reads the key of a record.
+        keyExtractor mExtractor;
+        //! The records by primary key.
+        KeyedHashTable<storedType, keyExtractor> mTable;
+        //! The secondary indexes.
+        tuple<indexTypes...> mIndexes;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Removes a record from every index it is in.
+         *  @param value The record to remove.
+         */
+        void eraseFromIndexes(storedType *value)
+        {
+            apply([value](indexTypes &... indexes) { (indexes.erase(value), ...); }, mIndexes);
+        }
+};
+#endif // _INCLUDE_INDEXEDHASHTABLE_H_
@@ -0,0 +1,319 @@
+/**
+ *  @file InternedHashTable.h
+ *  @brief Declaration for a string keyed HashTable that packs its keys into a StringArena.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_INTERNEDHASHTABLE_H_
+#define _INCLUDE_INTERNEDHASHTABLE_H_
+
+#include <string>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+#include "Arena.h"
+#include "HashTable.h"
+#include "RobinHood.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed HashTable mapping string keys to pointers of storedType, with the
+ *  keys interned into a single StringArena.
+ *  @param storedType The type of the values to point to in our InternedHashTable.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail Where HashTable constructs a std::string per key, which for anything past the small
+ *  string limit is a heap allocation of its own, the InternedHashTable copies each key once into
+ *  a bump allocated StringArena and its Buckets hold only the key's offset. That makes adding a
+ *  key allocation free in the common case, keeps the keys packed together in memory, and leaves
+ *  the whole key set in one buffer that getKeys() exposes for dumping. Buckets are probed with
+ *  Robin Hood displacement and removal shifts the rest of the cluster back, as in HashTable.
+ *
+ *  Removing a key only flags its bytes in the arena as dead. Once the dead bytes outweigh the
+ *  live ones, the live keys are copied into a fresh arena, reusing the hashes cached next to them.
+ *  @note The InternedHashTable does not own the values it points to.
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class InternedHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of Buckets to start with. It is rounded up to a
+         *  power of two.
+         *  @param initialKeyBytes The number of bytes to reserve for keys up front.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array or the keys.
+         */
+        InternedHashTable(const size_t &initialCapacity = 16, const size_t &initialKeyBytes = 0) :
+        mKeys(initialKeyBytes), mSize(0)
+        {
+            mCapacity = MIN_CAPACITY;
+            while (mCapacity < initialCapacity)
+                mCapacity <<= 1;
+
+            mBuckets = new Bucket[mCapacity]();
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~InternedHashTable(void)
+        {
+            delete[] mBuckets;
+        }
+
+        InternedHashTable(const InternedHashTable<storedType, hasherType> &) = delete;
+        InternedHashTable<storedType, hasherType>& operator =(const InternedHashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under. It is copied into the key arena.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the Bucket array or the key arena.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+
+            Bucket *bucket = findBucket(key, hash);
+            if (bucket)
+            {
+                bucket->value = value;
+                return false;
+            }
+
+            if ((mSize + 1) * MAX_LOAD_DENOMINATOR > mCapacity * MAX_LOAD_NUMERATOR)
+                resize(mCapacity << 1);
+
+            // The key goes into the arena first, so a failed allocation leaves the Buckets as they were
+            size_t offset = mKeys.add(key, hash);
+
+            bucket = RobinHood::claim(mBuckets, mCapacity, hash);
+            bucket->value = value;
+            bucket->offset = offset;
+
+            ++mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        storedType *find(string_view key) const
+        {
+            Bucket *bucket = findBucket(key, HashTable<storedType, hasherType>::hashKey(key.data(), key.size()));
+            return bucket ? bucket->value : NULL;
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this InternedHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes key and its value from this InternedHashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            Bucket *bucket = findBucket(key, HashTable<storedType, hasherType>::hashKey(key.data(), key.size()));
+
+            if (!bucket)
+                return false;
+
+            mKeys.release(bucket->offset);
+            RobinHood::erase(mBuckets, mCapacity, bucket);
+            --mSize;
+
+            if (mKeys.getDeadBytes() > MIN_COMPACTION_BYTES && mKeys.getDeadBytes() * 2 > mKeys.getSize())
+                compactKeys();
+
+            return true;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this InternedHashTable.
+         *  @param functor A callable accepting a string_view and a storedType *.
+         *  @note The InternedHashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t index = 0; index < mCapacity; index++)
+                if (mBuckets[index].distance)
+                    functor(mKeys.get(mBuckets[index].offset), mBuckets[index].value);
+        }
+
+        /**
+         *  @brief Returns the arena holding the keys, for instance to write the key set out.
+         *  @return A reference to the StringArena. Released keys are still in it, flagged as dead.
+         */
+        const StringArena &getKeys(void) const
+        {
+            return mKeys;
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this InternedHashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns the number of Buckets in this InternedHashTable.
+         *  @return The current capacity.
+         */
+        size_t getCapacity(void) const
+        {
+            return mCapacity;
+        }
+
+        /**
+         *  @brief Returns whether or not this InternedHashTable is empty.
+         *  @return A boolean representing whether or not this InternedHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put an InternedHashTable into a stream. Every value
+         *  is written on its own line, in Bucket order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The InternedHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const InternedHashTable<storedType, hasherType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](string_view, storedType *value)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << *value;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A slot of the InternedHashTable. It is empty when distance is zero.
+         */
+        struct Bucket
+        {
+            //! A pointer to the value stored for the key.
+            storedType *value;
+            //! The hash of the key. Its low bits select the home Bucket.
+            uint32_t hash;
+            //! One more than the distance from the home Bucket. Zero if this Bucket is empty.
+            uint32_t distance;
+            //! The offset of the key in mKeys.
+            size_t offset;
+        };
+
+        //! The smallest capacity the InternedHashTable will use.
+        static constexpr size_t MIN_CAPACITY = 8;
+        //! The InternedHashTable grows once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+        //! The InternedHashTable grows once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_DENOMINATOR = 8;
+        //! The key arena is never compacted while it holds fewer dead bytes than this.
+        static constexpr size_t MIN_COMPACTION_BYTES = 4096;
+
+        //! The keys.
+        StringArena mKeys;
+        //! The Buckets.
+        Bucket *mBuckets;
+        //! The number of Buckets. Always a power of two.
+        size_t mCapacity;
+        //! The number of keys stored.
+        size_t mSize;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Finds the Bucket holding a key.
+         *  @param key The key to look for.
+         *  @param hash The hash of the key.
+         *  @return A pointer to the Bucket, or NULL if the key is not present.
+         */
+        Bucket *findBucket(string_view key, const uint32_t &hash) const
+        {
+            return RobinHood::probe(mBuckets, mCapacity, hash, [this, &key](const Bucket &bucket)
+            {
+                return mKeys.get(bucket.offset) == key;
+            });
+        }
+
+        /**
+         *  @brief Moves every entry into a new Bucket array. Keys stay where they are in the arena.
+         *  @param capacity The new capacity. Must be a power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Bucket array.
+         */
+        void resize(const size_t &capacity)
+        {
+            Bucket *buckets = new Bucket[capacity]();
+
+            for (size_t index = 0; index < mCapacity; index++)
+                if (mBuckets[index].distance)
+                {
+                    Bucket *bucket = RobinHood::claim(buckets, capacity, mBuckets[index].hash);
+                    bucket->value = mBuckets[index].value;
+                    bucket->offset = mBuckets[index].offset;
+                }
+
+            delete[] mBuckets;
+            mBuckets = buckets;
+            mCapacity = capacity;
+        }
+
+        /**
+         *  @brief Copies the live keys into a fresh arena and points the Buckets at the copies.
+         *  @note The fresh arena is reserved at exactly the live size, so only its constructor can
+         *  fail. That failure is swallowed; the dead bytes simply stay around until the next attempt.
+         */
+        void compactKeys(void)
+        {
+            try
+            {
+                StringArena keys(mKeys.getSize() - mKeys.getDeadBytes());
+
+                for (size_t index = 0; index < mCapacity; index++)
+                    if (mBuckets[index].distance)
+                        mBuckets[index].offset = keys.add(mKeys.get(mBuckets[index].offset), mBuckets[index].hash);
+
+                mKeys.swap(keys);
+            }
+            catch (bad_alloc &)
+            {
+
+            }
+        }
+};
+#endif // _INCLUDE_INTERNEDHASHTABLE_H_
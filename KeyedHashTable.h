@@ -0,0 +1,335 @@
+/**
+ *  @file KeyedHashTable.h
+ *  @brief Declaration for a HashTable whose keys are read out of the values it stores.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_KEYEDHASHTABLE_H_
+#define _INCLUDE_KEYEDHASHTABLE_H_
+
+#include <new>
+#include <string>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+#include "HashTable.h"
+#include "RobinHood.h"
+
+using namespace std;
+
+/**
+ *  @brief A key extractor reading a string member of a record.
+ *  @param recordType The type of the record.
+ *  @param member A pointer to the string member holding the key.
+ */
+template <typename recordType, string recordType::*member>
+struct MemberKey
+{
+    /**
+     *  @brief Returns the key of a record.
+     *  @param record The record to read the key of.
+     *  @return A reference to the member holding the key.
+     */
+    const string &operator ()(const recordType &record) const
+    {
+        return record.*member;
+    }
+};
+
+/**
+ *  @brief A generically typed hash set of pointers to storedType, looked up by a string key that
+ *  each value carries itself.
+ *  @param storedType The type of the values to point to in our KeyedHashTable.
+ *  @param keyExtractor A default constructible callable that accepts a const storedType & and
+ *  returns its key as anything convertible to string_view, such as MemberKey.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail Storing only the value pointer, the hash and the probe distance keeps every Bucket at
+ *  sixteen bytes on 64 bit targets, a third of a HashTable Bucket with its inline string key,
+ *  and the key characters are not copied at all. Buckets are probed with Robin Hood
+ *  displacement and removal shifts the rest of the cluster back, as in HashTable. Since the
+ *  stored hash must be rechecked against the key in the value, a value's key must not change
+ *  while it is in the KeyedHashTable.
+ *  @note The KeyedHashTable does not own the values it points to.
+ */
+template <typename storedType, typename keyExtractor, typename hasherType = FNV1aHasher>
+class KeyedHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of Buckets to start with. It is rounded up to a
+         *  power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        KeyedHashTable(const size_t &initialCapacity = 16) : mSize(0)
+        {
+            mCapacity = MIN_CAPACITY;
+            while (mCapacity < initialCapacity)
+                mCapacity <<= 1;
+
+            mBuckets = new Bucket[mCapacity]();
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~KeyedHashTable(void)
+        {
+            delete[] mBuckets;
+        }
+
+        KeyedHashTable(const KeyedHashTable<storedType, keyExtractor, hasherType> &) = delete;
+        KeyedHashTable<storedType, keyExtractor, hasherType>& operator =(const KeyedHashTable<storedType, keyExtractor, hasherType> &) = delete;
+
+        /**
+         *  @brief Adds value under its own key, replacing any value already stored with an equal key.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not the key of value was newly added.
+         *  @retval false Returned if the key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the Bucket array.
+         */
+        bool add(storedType *value)
+        {
+            string_view key = mExtractor(*value);
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+
+            Bucket *bucket = findBucket(key, hash);
+            if (bucket)
+            {
+                bucket->value = value;
+                return false;
+            }
+
+            if ((mSize + 1) * MAX_LOAD_DENOMINATOR > mCapacity * MAX_LOAD_NUMERATOR)
+                resize(mCapacity << 1);
+
+            RobinHood::claim(mBuckets, mCapacity, hash)->value = value;
+            ++mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value whose key equals key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value with that key, or NULL if there is none.
+         */
+        storedType *find(string_view key) const
+        {
+            Bucket *bucket = findBucket(key, HashTable<storedType, hasherType>::hashKey(key.data(), key.size()));
+            return bucket ? bucket->value : NULL;
+        }
+
+        /**
+         *  @brief Returns whether or not a value with key is present in this KeyedHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes the value whose key equals key from this KeyedHashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            Bucket *bucket = findBucket(key, HashTable<storedType, hasherType>::hashKey(key.data(), key.size()));
+
+            if (!bucket)
+                return false;
+
+            RobinHood::erase(mBuckets, mCapacity, bucket);
+
+            --mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Calls functor with every value in this KeyedHashTable.
+         *  @param functor A callable accepting a storedType *.
+         *  @note The KeyedHashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t index = 0; index < mCapacity; index++)
+                if (mBuckets[index].distance)
+                    functor(mBuckets[index].value);
+        }
+
+        //! The summary getStatistics() returns, in the same form as for a HashTable.
+        typedef typename HashTable<storedType, hasherType>::Statistics Statistics;
+
+        /**
+         *  @brief Returns a summary of the state of this KeyedHashTable. It never migrates and
+         *  holds no keys of its own, so the migration fields, movedBuckets and keyBytes are zero.
+         *  @return The Statistics of this KeyedHashTable.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the probe length histogram.
+         */
+        Statistics getStatistics(void) const
+        {
+            Statistics result;
+
+            result.size = mSize;
+            result.capacity = mCapacity;
+            result.loadFactor = static_cast<double>(mSize) / mCapacity;
+            result.migrating = false;
+            result.migratedBuckets = 0;
+            result.migrationBuckets = 0;
+            result.migrationProgress = 1.0;
+            result.maxProbeLength = 0;
+            result.movedBuckets = 0;
+
+            size_t probeTotal = 0;
+            for (size_t index = 0; index < mCapacity; index++)
+            {
+                size_t length = mBuckets[index].distance;
+                if (!length)
+                    continue;
+
+                if (result.probeLengths.size() <= length)
+                    result.probeLengths.resize(length + 1);
+
+                ++result.probeLengths[length];
+                probeTotal += length;
+                if (length > result.maxProbeLength)
+                    result.maxProbeLength = length;
+            }
+
+            result.meanProbeLength = mSize ? static_cast<double>(probeTotal) / mSize : 0.0;
+            result.bucketBytes = mCapacity * sizeof(Bucket);
+            result.keyBytes = 0;
+            result.valueBytes = mSize * sizeof(storedType);
+            result.totalBytes = result.bucketBytes;
+
+            return result;
+        }
+
+        /**
+         *  @brief Returns the number of values stored in this KeyedHashTable.
+         *  @return The number of values currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns the number of Buckets in this KeyedHashTable.
+         *  @return The current capacity.
+         */
+        size_t getCapacity(void) const
+        {
+            return mCapacity;
+        }
+
+        /**
+         *  @brief Returns whether or not this KeyedHashTable is empty.
+         *  @return A boolean representing whether or not this KeyedHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a KeyedHashTable into a stream. Every value
+         *  is written on its own line, in Bucket order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The KeyedHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const KeyedHashTable<storedType, keyExtractor, hasherType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](storedType *value)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << *value;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A slot of the KeyedHashTable. It is empty when distance is zero.
+         */
+        struct Bucket
+        {
+            //! A pointer to the value, which holds the key.
+            storedType *value;
+            //! The hash of the key of value. Its low bits select the home Bucket.
+            uint32_t hash;
+            //! One more than the distance from the home Bucket. Zero if this Bucket is empty.
+            uint32_t distance;
+        };
+
+        //! The smallest capacity the KeyedHashTable will use.
+        static constexpr size_t MIN_CAPACITY = 8;
+        //! The KeyedHashTable grows once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+        //! The KeyedHashTable grows once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_DENOMINATOR = 8;
+
+        //! Reads the key out of a value.
+        keyExtractor mExtractor;
+        //! The Buckets.
+        Bucket *mBuckets;
+        //! The number of Buckets. Always a power of two.
+        size_t mCapacity;
+        //! The number of values stored.
+        size_t mSize;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Finds the Bucket holding the value with a key.
+         *  @param key The key to look for.
+         *  @param hash The hash of the key.
+         *  @return A pointer to the Bucket, or NULL if the key is not present.
+         */
+        Bucket *findBucket(string_view key, const uint32_t &hash) const
+        {
+            return RobinHood::probe(mBuckets, mCapacity, hash, [this, &key](const Bucket &bucket)
+            {
+                return string_view(mExtractor(*bucket.value)) == key;
+            });
+        }
+
+        /**
+         *  @brief Moves every value into a new Bucket array. Stored hashes are reused, so no
+         *  key is read.
+         *  @param capacity The new capacity. Must be a power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Bucket array.
+         */
+        void resize(const size_t &capacity)
+        {
+            Bucket *buckets = new Bucket[capacity]();
+
+            for (size_t index = 0; index < mCapacity; index++)
+                if (mBuckets[index].distance)
+                    RobinHood::claim(buckets, capacity, mBuckets[index].hash)->value = mBuckets[index].value;
+
+            delete[] mBuckets;
+            mBuckets = buckets;
+            mCapacity = capacity;
+        }
+};
+#endif // _INCLUDE_KEYEDHASHTABLE_H_
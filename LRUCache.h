@@ -0,0 +1,364 @@
+/**
+ *  @file LRUCache.h
+ *  @brief Declaration for a string keyed cache of bounded size that evicts the least recently
+ *  used entry.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_LRUCACHE_H_
+#define _INCLUDE_LRUCACHE_H_
+
+#include <string>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+#include "Arena.h"
+#include "KeyedHashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed cache mapping string keys to values of storedType that it owns,
+ *  holding at most a fixed number of entries.
+ *  @param storedType The type of the values stored in our LRUCache.
+ *  @detail Every entry is a Node holding its key, its value and the links of a doubly linked
+ *  recency list running from the most to the least recently used entry. A KeyedHashTable finds
+ *  Nodes by the key inside them, so the key is stored once, and it is sized for the full capacity
+ *  up front so that it never grows. A hit moves its Node to the front of the list; adding to a
+ *  full cache evicts the Node at the back. Both are a handful of pointer updates. Nodes come
+ *  from an ObjectArena, so an evicted Node's memory is reused by the next one added.
+ */
+template <typename storedType>
+class LRUCache
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the maximum number of entries.
+         *  @param capacity The most entries the LRUCache holds at once. Zero is treated as one.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the index.
+         */
+        LRUCache(const size_t &capacity) : mCapacity(capacity ? capacity : 1),
+        mIndex((capacity ? capacity : 1) * 8 / 7 + 1), mHead(NULL), mTail(NULL), mHits(0), mMisses(0), mEvictions(0)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Destroys every value.
+         */
+        ~LRUCache(void)
+        {
+            clear();
+        }
+
+        LRUCache(const LRUCache<storedType> &) = delete;
+        LRUCache<storedType>& operator =(const LRUCache<storedType> &) = delete;
+
+        /**
+         *  @brief Looks up the value cached for key and marks it as the most recently used.
+         *  Counts as a hit or a miss.
+         *  @param key The key to look up.
+         *  @return A pointer to the value cached for key, or NULL if key is not cached. It stays
+         *  valid until the value is evicted, replaced or removed.
+         */
+        storedType *find(string_view key)
+        {
+            Node *node = mIndex.find(key);
+
+            if (!node)
+            {
+                ++mMisses;
+                return NULL;
+            }
+
+            ++mHits;
+            unlink(node);
+            pushFront(node);
+            return &node->value;
+        }
+
+        /**
+         *  @brief Looks up the value cached for key without touching its recency or the counters.
+         *  @param key The key to look up.
+         *  @return A pointer to the value cached for key, or NULL if key is not cached.
+         */
+        const storedType *peek(string_view key) const
+        {
+            Node *node = mIndex.find(key);
+            return node ? &node->value : NULL;
+        }
+
+        /**
+         *  @brief Returns whether or not key is cached, without touching its recency or the counters.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is cached.
+         */
+        bool contains(string_view key) const
+        {
+            return mIndex.contains(key);
+        }
+
+        /**
+         *  @brief Constructs a value from arguments and caches it under key as the most recently
+         *  used entry, replacing any value already cached for key. When a new key is added to a
+         *  full LRUCache, the least recently used entry is evicted.
+         *  @param key The key to cache the value under.
+         *  @param arguments The arguments to pass to the constructor of storedType.
+         *  @return A reference to the new value.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the entry. Anything thrown by the constructor of storedType is passed on.
+         *  Either way the LRUCache is unchanged.
+         */
+        template <typename... argumentTypes>
+        storedType &emplace(string_view key, argumentTypes&&... arguments)
+        {
+            // The new Node is built before anything is evicted, so a throwing constructor costs nothing
+            Node *node = mNodes.create(key, std::forward<argumentTypes>(arguments)...);
+            Node *previous = mIndex.find(key);
+
+            if (previous)
+                erase(previous);
+            else if (mIndex.getSize() == mCapacity)
+            {
+                erase(mTail);
+                ++mEvictions;
+            }
+
+            mIndex.add(node);
+            pushFront(node);
+            return node->value;
+        }
+
+        /**
+         *  @brief Removes key from this LRUCache and destroys its value.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not cached.
+         */
+        bool remove(string_view key)
+        {
+            Node *node = mIndex.find(key);
+
+            if (!node)
+                return false;
+
+            erase(node);
+            return true;
+        }
+
+        /**
+         *  @brief Removes every entry. The counters are kept.
+         */
+        void clear(void)
+        {
+            while (mTail)
+                erase(mTail);
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this LRUCache, from the most to
+         *  the least recently used.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note The LRUCache must not be modified while this is running, which includes find().
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (Node *node = mHead; node; node = node->pNext)
+                functor(node->key, &node->value);
+        }
+
+        /**
+         *  @brief A summary of how well an LRUCache is doing.
+         */
+        struct Statistics
+        {
+            //! The number of entries cached.
+            size_t size;
+            //! The most entries that can be cached at once.
+            size_t capacity;
+            //! The number of find() calls that found their key.
+            uint64_t hits;
+            //! The number of find() calls that did not find their key.
+            uint64_t misses;
+            //! The number of entries evicted to make room for new keys.
+            uint64_t evictions;
+            //! hits divided by the number of find() calls, or zero before the first.
+            double hitRate;
+        };
+
+        /**
+         *  @brief Returns the counters of this LRUCache.
+         *  @return The Statistics of this LRUCache.
+         */
+        Statistics getStatistics(void) const
+        {
+            Statistics result;
+
+            result.size = mIndex.getSize();
+            result.capacity = mCapacity;
+            result.hits = mHits;
+            result.misses = mMisses;
+            result.evictions = mEvictions;
+            result.hitRate = mHits + mMisses ? static_cast<double>(mHits) / (mHits + mMisses) : 0.0;
+
+            return result;
+        }
+
+        /**
+         *  @brief Sets the hit, miss and eviction counters back to zero.
+         */
+        void resetStatistics(void)
+        {
+            mHits = mMisses = mEvictions = 0;
+        }
+
+        /**
+         *  @brief Returns the number of entries cached in this LRUCache.
+         *  @return The number of entries currently cached.
+         */
+        size_t getSize(void) const
+        {
+            return mIndex.getSize();
+        }
+
+        /**
+         *  @brief Returns the most entries this LRUCache holds at once.
+         *  @return The capacity passed to the constructor.
+         */
+        size_t getCapacity(void) const
+        {
+            return mCapacity;
+        }
+
+        /**
+         *  @brief Returns whether or not this LRUCache is empty.
+         *  @return A boolean representing whether or not this LRUCache is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mIndex.isEmpty();
+        }
+
+        /**
+         *  @brief Stream insertion operator to put an LRUCache into a stream. Every value is
+         *  written on its own line, from the most to the least recently used.
+         *  @param stream The std::ostream to write into.
+         *  @param input The LRUCache to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const LRUCache<storedType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](const string &, storedType *value)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << *value;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  An entry of the LRUCache.
+         */
+        struct Node
+        {
+            /**
+             *  @brief Constructor accepting the key and the arguments for the value.
+             *  @param key The key of the entry.
+             *  @param arguments The arguments to pass to the constructor of storedType.
+             */
+            template <typename... argumentTypes>
+            Node(string_view key, argumentTypes&&... arguments) : key(key),
+            value(std::forward<argumentTypes>(arguments)...), pPrevious(NULL), pNext(NULL)
+            {
+
+            }
+
+            //! The key of the entry, which the index reads.
+            string key;
+            //! The cached value.
+            storedType value;
+            //! The next more recently used Node. NULL if this is the most recently used.
+            Node *pPrevious;
+            //! The next less recently used Node. NULL if this is the least recently used.
+            Node *pNext;
+        };
+
+        //! The most entries cached at once.
+        size_t mCapacity;
+        //! Holds the Nodes.
+        ObjectArena<Node> mNodes;
+        //! Finds Nodes by key.
+        KeyedHashTable<Node, MemberKey<Node, &Node::key> > mIndex;
+        //! The most recently used Node. NULL if the LRUCache is empty.
+        Node *mHead;
+        //! The least recently used Node. NULL if the LRUCache is empty.
+        Node *mTail;
+        //! The number of find() calls that found their key.
+        uint64_t mHits;
+        //! The number of find() calls that did not find their key.
+        uint64_t mMisses;
+        //! The number of entries evicted.
+        uint64_t mEvictions;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Takes a Node out of the recency list.
+         *  @param node The Node to unlink.
+         */
+        void unlink(Node *node)
+        {
+            if (node->pPrevious)
+                node->pPrevious->pNext = node->pNext;
+            else
+                mHead = node->pNext;
+
+            if (node->pNext)
+                node->pNext->pPrevious = node->pPrevious;
+            else
+                mTail = node->pPrevious;
+
+            node->pPrevious = node->pNext = NULL;
+        }
+
+        /**
+         *  @brief Puts an unlinked Node at the front of the recency list.
+         *  @param node The Node to make the most recently used.
+         */
+        void pushFront(Node *node)
+        {
+            node->pNext = mHead;
+
+            if (mHead)
+                mHead->pPrevious = node;
+            else
+                mTail = node;
+
+            mHead = node;
+        }
+
+        /**
+         *  @brief Removes a Node from the index and the recency list and destroys it.
+         *  @param node The Node to erase.
+         */
+        void erase(Node *node)
+        {
+            mIndex.remove(node->key);
+            unlink(node);
+            mNodes.destroy(node);
+        }
+};
+#endif // _INCLUDE_LRUCACHE_H_
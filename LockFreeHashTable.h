@@ -0,0 +1,392 @@
+/**
+ *  @file LockFreeHashTable.h
+ *  @brief Declaration for a string keyed HashTable whose lookups take no locks.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_LOCKFREEHASHTABLE_H_
+#define _INCLUDE_LOCKFREEHASHTABLE_H_
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <stdint.h>
+#include <iostream>
+
+#include "HashTable.h"
+#include "EpochReclaimer.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed HashTable mapping string keys to pointers of storedType, built for
+ *  read mostly workloads shared between many threads.
+ *  @param storedType The type of the values to point to in our LockFreeHashTable.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail find() takes no locks at all. The table is an array of chains of immutable Nodes;
+ *  writers serialize on a mutex, build whatever they change off to the side and publish it with
+ *  a single release store: a new Node becomes the head of its chain, a removal swings its
+ *  predecessor's link past it, a replaced value is stored into the Node, and growing publishes a
+ *  whole new Bucket array built from copies of the Nodes. Anything unlinked is retired through an
+ *  EpochReclaimer, and readers hold an EpochReclaimer::Guard while they walk, so nothing they can
+ *  reach is freed underneath them.
+ *  @note The LockFreeHashTable does not own the values it points to.
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class LockFreeHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of chains to start with. It is rounded up to a
+         *  power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        LockFreeHashTable(const size_t &initialCapacity = 16) : mSize(0)
+        {
+            size_t capacity = MIN_CAPACITY;
+            while (capacity < initialCapacity)
+                capacity <<= 1;
+
+            mTable.store(Table::create(capacity), memory_order_relaxed);
+        }
+
+        /**
+         *  @brief Standard destructor. No reader may still be inside find().
+         */
+        ~LockFreeHashTable(void)
+        {
+            Table::destroy(mTable.load(memory_order_relaxed), true);
+        }
+
+        LockFreeHashTable(const LockFreeHashTable<storedType, hasherType> &) = delete;
+        LockFreeHashTable<storedType, hasherType>& operator =(const LockFreeHashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Node or Bucket array.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+            lock_guard<mutex> lock(mWriteLock);
+
+            Table *table = mTable.load(memory_order_relaxed);
+            atomic<Node *> &bucket = table->buckets[hash & table->mask];
+
+            for (Node *current = bucket.load(memory_order_relaxed); current; current = current->next.load(memory_order_relaxed))
+                if (current->matches(key.data(), key.size(), hash))
+                {
+                    current->value.store(value, memory_order_release);
+                    return false;
+                }
+
+            if ((mSize.load(memory_order_relaxed) + 1) * MAX_LOAD_DENOMINATOR > (table->mask + 1) * MAX_LOAD_NUMERATOR)
+                grow();
+
+            insert(key, value, hash);
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key without taking any lock.
+         *  @param key The key to look up.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        storedType *find(string_view key) const
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+            EpochReclaimer::Guard guard(mReclaimer);
+
+            Table *table = mTable.load(memory_order_acquire);
+            for (Node *current = table->buckets[hash & table->mask].load(memory_order_acquire); current;
+                 current = current->next.load(memory_order_acquire))
+                if (current->matches(key.data(), key.size(), hash))
+                    return current->value.load(memory_order_acquire);
+
+            return NULL;
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this LockFreeHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes key and its value from this LockFreeHashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+            lock_guard<mutex> lock(mWriteLock);
+
+            Table *table = mTable.load(memory_order_relaxed);
+            atomic<Node *> *link = &table->buckets[hash & table->mask];
+
+            for (Node *current = link->load(memory_order_relaxed); current; current = link->load(memory_order_relaxed))
+            {
+                if (current->matches(key.data(), key.size(), hash))
+                {
+                    // Readers already on current still follow its link onward, which is left intact
+                    link->store(current->next.load(memory_order_relaxed), memory_order_release);
+                    mReclaimer.retire(current);
+
+                    mSize.fetch_sub(1, memory_order_relaxed);
+                    return true;
+                }
+
+                link = &current->next;
+            }
+
+            return false;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this LockFreeHashTable.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note This runs under the write lock, so it sees a consistent table but blocks writers.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            lock_guard<mutex> lock(mWriteLock);
+            Table *table = mTable.load(memory_order_relaxed);
+
+            for (size_t index = 0; index <= table->mask; index++)
+                for (Node *current = table->buckets[index].load(memory_order_relaxed); current;
+                     current = current->next.load(memory_order_relaxed))
+                    functor(current->key, current->value.load(memory_order_relaxed));
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this LockFreeHashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize.load(memory_order_relaxed);
+        }
+
+        /**
+         *  @brief Frees retired memory that no reader can reach anymore.
+         *  @return The number of retired items still waiting to be freed.
+         */
+        size_t collect(void)
+        {
+            return mReclaimer.collect();
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a LockFreeHashTable into a stream. Every value
+         *  is written on its own line, in chain order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The LockFreeHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const LockFreeHashTable<storedType, hasherType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](const string &, storedType *value)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << *value;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A key and value pair in a chain. Everything but value and next is immutable once the
+         *  Node has been published.
+         */
+        struct Node
+        {
+            /**
+             *  @brief Constructor accepting the contents of the Node.
+             *  @param key The key of the Node.
+             *  @param value A pointer to the value stored for key.
+             *  @param hash The hash of key.
+             */
+            Node(string_view key, storedType *value, const uint32_t &hash) : key(key), hash(hash), value(value), next(NULL)
+            {
+
+            }
+
+            /**
+             *  @brief Returns whether or not this Node holds a given key.
+             *  @param otherKey A pointer to the characters of the key.
+             *  @param length The number of characters in the key.
+             *  @param otherHash The hash of the key.
+             *  @return A boolean representing whether or not the keys are equal.
+             */
+            bool matches(const char *otherKey, const size_t &length, const uint32_t &otherHash) const
+            {
+                return hash == otherHash && key.size() == length && !key.compare(0, length, otherKey, length);
+            }
+
+            //! The key stored in this Node.
+            const string key;
+            //! The hash of key.
+            const uint32_t hash;
+            //! A pointer to the value stored for key.
+            atomic<storedType *> value;
+            //! The next Node of the chain. NULL if this is the last.
+            atomic<Node *> next;
+        };
+
+        /**
+         *  A Bucket array of chain heads.
+         */
+        struct Table
+        {
+            //! The number of chains minus one. The number of chains is a power of two.
+            size_t mask;
+            //! The heads of the chains.
+            atomic<Node *> *buckets;
+
+            /**
+             *  @brief Allocates a Table of empty chains.
+             *  @param capacity The number of chains. Must be a power of two.
+             *  @return The new Table.
+             *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+             *  the heap for the Table.
+             */
+            static Table *create(const size_t &capacity)
+            {
+                Table *result = new Table;
+
+                try
+                {
+                    result->buckets = new atomic<Node *>[capacity]();
+                }
+                catch (bad_alloc &e)
+                {
+                    delete result;
+                    throw;
+                }
+
+                result->mask = capacity - 1;
+                return result;
+            }
+
+            /**
+             *  @brief Frees a Table, and optionally every Node still chained into it.
+             *  @param table The Table to free.
+             *  @param nodes Whether or not to delete the Nodes as well.
+             */
+            static void destroy(Table *table, const bool &nodes)
+            {
+                if (nodes)
+                    for (size_t index = 0; index <= table->mask; index++)
+                    {
+                        Node *current = table->buckets[index].load(memory_order_relaxed);
+
+                        while (current)
+                        {
+                            Node *next = current->next.load(memory_order_relaxed);
+                            delete current;
+                            current = next;
+                        }
+                    }
+
+                delete[] table->buckets;
+                delete table;
+            }
+        };
+
+        //! The smallest capacity the LockFreeHashTable will use.
+        static constexpr size_t MIN_CAPACITY = 8;
+        //! The LockFreeHashTable grows once it holds more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR keys per chain.
+        static constexpr size_t MAX_LOAD_NUMERATOR = 1;
+        //! The LockFreeHashTable grows once it holds more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR keys per chain.
+        static constexpr size_t MAX_LOAD_DENOMINATOR = 1;
+
+        //! The published Bucket array.
+        atomic<Table *> mTable;
+        //! The number of keys stored.
+        atomic<size_t> mSize;
+        //! Serializes writers.
+        mutable mutex mWriteLock;
+        //! Frees unlinked Nodes and Tables once readers are done with them.
+        mutable EpochReclaimer mReclaimer;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Publishes a new Node for a key known not to be present. mWriteLock must be held.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @param hash The hash of key.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Node.
+         */
+        void insert(string_view key, storedType *value, const uint32_t &hash)
+        {
+            Table *table = mTable.load(memory_order_relaxed);
+            atomic<Node *> &bucket = table->buckets[hash & table->mask];
+
+            Node *node = new Node(key, value, hash);
+            node->next.store(bucket.load(memory_order_relaxed), memory_order_relaxed);
+            bucket.store(node, memory_order_release);
+
+            mSize.fetch_add(1, memory_order_relaxed);
+        }
+
+        /**
+         *  @brief Publishes a Bucket array twice the size, chained from copies of the current
+         *  Nodes, and retires the current array together with its Nodes. mWriteLock must be held.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new Table or Nodes.
+         */
+        void grow(void)
+        {
+            Table *old = mTable.load(memory_order_relaxed);
+            Table *table = Table::create((old->mask + 1) << 1);
+
+            // Readers may be walking the old chains, so their links cannot be rewired; copy instead
+            try
+            {
+                for (size_t index = 0; index <= old->mask; index++)
+                    for (Node *current = old->buckets[index].load(memory_order_relaxed); current;
+                         current = current->next.load(memory_order_relaxed))
+                    {
+                        atomic<Node *> &bucket = table->buckets[current->hash & table->mask];
+                        Node *node = new Node(current->key, current->value.load(memory_order_relaxed), current->hash);
+
+                        node->next.store(bucket.load(memory_order_relaxed), memory_order_relaxed);
+                        bucket.store(node, memory_order_relaxed);
+                    }
+            }
+            catch (bad_alloc &e)
+            {
+                Table::destroy(table, true);
+                throw;
+            }
+
+            mTable.store(table, memory_order_release);
+            mReclaimer.retire(old, [](void *pointer) { Table::destroy(static_cast<Table *>(pointer), true); });
+        }
+};
+#endif // _INCLUDE_LOCKFREEHASHTABLE_H_
@@ -0,0 +1,475 @@
+/**
+ *  @file MappedHashTable.h
+ *  @brief Declaration for a string to string HashTable stored in a file and served straight
+ *  from a read only memory mapping of it.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_MAPPEDHASHTABLE_H_
+#define _INCLUDE_MAPPEDHASHTABLE_H_
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <fstream>
+#include <stdint.h>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Arena.h"
+#include "Hashers.h"
+#include "RobinHood.h"
+
+using namespace std;
+
+/**
+ *  @brief The layout shared by MappedHashTableWriter and MappedHashTable.
+ *  @detail A file starts with a Header, followed by a Robin Hood Bucket array like HashTable's
+ *  and then a string pool, which is a StringArena written out as is. Buckets refer to their key
+ *  and value by offset into the pool and the sections are located by offsets in the Header, so
+ *  the file contains no pointers and can be used wherever it is mapped. Keys are hashed with
+ *  FNV-1a, which does not depend on the machine, folded to 32 bits. Numbers are stored in native
+ *  byte order; the Header records which, and files from a machine of the other order are refused.
+ */
+struct MappedHashTableFormat
+{
+    /**
+     *  The start of a file.
+     */
+    struct Header
+    {
+        //! Always MAGIC.
+        char magic[8];
+        //! Always VERSION.
+        uint32_t version;
+        //! BYTE_ORDER_MARK as written by the machine that wrote the file.
+        uint32_t byteOrder;
+        //! The number of keys.
+        uint64_t size;
+        //! The number of Buckets. Always a power of two.
+        uint64_t capacity;
+        //! The offset of the Bucket array from the start of the file.
+        uint64_t bucketsOffset;
+        //! The offset of the string pool from the start of the file.
+        uint64_t poolOffset;
+        //! The number of bytes in the string pool.
+        uint64_t poolSize;
+    };
+
+    /**
+     *  A slot of the Bucket array. It is empty when distance is zero.
+     */
+    struct Bucket
+    {
+        //! The offset of the key in the string pool.
+        uint64_t key;
+        //! The offset of the value in the string pool.
+        uint64_t value;
+        //! The hash of the key. Its low bits select the home Bucket.
+        uint32_t hash;
+        //! One more than the distance from the home Bucket. Zero if this Bucket is empty.
+        uint32_t distance;
+    };
+
+    //! Identifies a MappedHashTable file.
+    static constexpr char MAGIC[8] = { 'H', 'T', 'M', 'A', 'P', 'P', 'E', 'D' };
+    //! The version of the layout described here.
+    static constexpr uint32_t VERSION = 1;
+    //! Reads back differently on a machine of the other byte order.
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304U;
+    //! The sections after the Header start on multiples of this.
+    static constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+    /**
+     *  @brief Hashes a key the way every MappedHashTable file does.
+     *  @param key The key to hash.
+     *  @return The hash of the key.
+     */
+    static uint32_t hashKey(string_view key)
+    {
+        uint64_t hash = FNV1aHasher::hash(key.data(), key.size());
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+};
+
+/**
+ *  @brief Collects key and value pairs and writes them out as a file for MappedHashTable.
+ *  @detail The pairs are packed into a StringArena as they are added, so the memory used is
+ *  about the size of the file. The Bucket array is only laid out by write(). When a key is
+ *  added more than once, the value added last wins.
+ */
+class MappedHashTableWriter
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Parameter-less constructor.
+         */
+        MappedHashTableWriter(void)
+        {
+
+        }
+
+        MappedHashTableWriter(const MappedHashTableWriter &) = delete;
+        MappedHashTableWriter& operator =(const MappedHashTableWriter &) = delete;
+
+        /**
+         *  @brief Adds a key and value pair to be written.
+         *  @param key The key.
+         *  @param value The value stored for key.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the pair.
+         */
+        void add(string_view key, string_view value)
+        {
+            Pair pair;
+            pair.hash = MappedHashTableFormat::hashKey(key);
+            pair.key = mPool.add(key, pair.hash);
+            pair.value = mPool.add(value, 0);
+
+            mPairs.push_back(pair);
+        }
+
+        /**
+         *  @brief Writes every pair added so far to a file, replacing it.
+         *  @param path The path of the file to write.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if the file could not be written. Any existing file at path is
+         *  left untouched, as the data is written and synced to a temporary file first and renamed
+         *  over it.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        bool write(const string &path) const
+        {
+            typedef MappedHashTableFormat Format;
+
+            uint64_t capacity = 8;
+            while (mPairs.size() * 8 > capacity * 7)
+                capacity <<= 1;
+
+            vector<Format::Bucket> buckets(capacity, Format::Bucket());
+            uint64_t size = 0;
+
+            for (size_t index = 0; index < mPairs.size(); index++)
+                if (insert(buckets, mPairs[index]))
+                    ++size;
+
+            Format::Header header;
+            memcpy(header.magic, Format::MAGIC, sizeof(header.magic));
+            header.version = Format::VERSION;
+            header.byteOrder = Format::BYTE_ORDER_MARK;
+            header.size = size;
+            header.capacity = capacity;
+            header.bucketsOffset = align(sizeof(Format::Header));
+            header.poolOffset = align(header.bucketsOffset + capacity * sizeof(Format::Bucket));
+            header.poolSize = mPool.getSize();
+
+            string temporary = path + ".tmp";
+            ofstream output(temporary.c_str(), ios::binary | ios::trunc);
+
+            output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            pad(output, header.bucketsOffset - sizeof(header));
+            output.write(reinterpret_cast<const char *>(&buckets[0]), capacity * sizeof(Format::Bucket));
+            pad(output, header.poolOffset - header.bucketsOffset - capacity * sizeof(Format::Bucket));
+            if (header.poolSize)
+                output.write(mPool.getData(), header.poolSize);
+
+            output.close();
+
+            // Synced before the rename, so a crash can never leave path naming a partial file
+            int descriptor = output ? ::open(temporary.c_str(), O_RDONLY) : -1;
+            bool synced = descriptor >= 0 && !fsync(descriptor);
+            if (descriptor >= 0)
+                ::close(descriptor);
+
+            if (!synced)
+            {
+                remove(temporary.c_str());
+                return false;
+            }
+
+            return rename(temporary.c_str(), path.c_str()) == 0;
+        }
+
+        /**
+         *  @brief Returns the number of pairs added so far, counting repeated keys every time.
+         *  @return The number of calls to add().
+         */
+        size_t getSize(void) const
+        {
+            return mPairs.size();
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A pair added to the writer.
+         */
+        struct Pair
+        {
+            //! The offset of the key in mPool.
+            uint64_t key;
+            //! The offset of the value in mPool.
+            uint64_t value;
+            //! The hash of the key.
+            uint32_t hash;
+        };
+
+        //! The keys and values.
+        StringArena mPool;
+        //! The pairs, in the order they were added.
+        vector<Pair> mPairs;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Places a pair in the Bucket array, or replaces the value of an equal key.
+         *  @param buckets The Bucket array.
+         *  @param pair The pair to place.
+         *  @return A boolean representing whether or not the key was newly added.
+         */
+        bool insert(vector<MappedHashTableFormat::Bucket> &buckets, const Pair &pair) const
+        {
+            string_view key = mPool.get(pair.key);
+            MappedHashTableFormat::Bucket *bucket = RobinHood::probe(buckets.data(), buckets.size(), pair.hash,
+                [this, &key](const MappedHashTableFormat::Bucket &candidate) { return mPool.get(candidate.key) == key; });
+
+            if (bucket)
+            {
+                bucket->value = pair.value;
+                return false;
+            }
+
+            bucket = RobinHood::claim(buckets.data(), buckets.size(), pair.hash);
+            bucket->key = pair.key;
+            bucket->value = pair.value;
+            return true;
+        }
+
+        /**
+         *  @brief Rounds an offset up to the next section boundary.
+         *  @param offset The offset to round.
+         *  @return The rounded offset.
+         */
+        static uint64_t align(const uint64_t &offset)
+        {
+            return (offset + MappedHashTableFormat::SECTION_ALIGNMENT - 1) & ~(MappedHashTableFormat::SECTION_ALIGNMENT - 1);
+        }
+
+        /**
+         *  @brief Writes zero bytes.
+         *  @param output The stream to write into.
+         *  @param count The number of bytes to write.
+         */
+        static void pad(ofstream &output, uint64_t count)
+        {
+            static const char zeros[MappedHashTableFormat::SECTION_ALIGNMENT] = { };
+
+            for (; count; count -= count < sizeof(zeros) ? count : sizeof(zeros))
+                output.write(zeros, count < sizeof(zeros) ? count : sizeof(zeros));
+        }
+};
+
+/**
+ *  @brief A read only string to string HashTable served directly from a file written by
+ *  MappedHashTableWriter.
+ *  @detail open() maps the file and checks its Header, and that is all the loading there is:
+ *  lookups probe the mapped Bucket array and compare against the mapped string pool, so pages
+ *  are only read from disk as lookups touch them, and every process mapping the same file
+ *  shares one copy in the page cache.
+ *  @note Offsets read from the file are bounds checked, so a damaged file yields failed
+ *  lookups rather than crashes, though not necessarily correct ones.
+ */
+class MappedHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Parameter-less constructor. The MappedHashTable is empty until open() is called.
+         */
+        MappedHashTable(void) : mMapping(NULL), mMappingSize(0), mHeader(NULL), mBuckets(NULL), mPool(NULL)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Unmaps the file.
+         */
+        ~MappedHashTable(void)
+        {
+            close();
+        }
+
+        MappedHashTable(const MappedHashTable &) = delete;
+        MappedHashTable& operator =(const MappedHashTable &) = delete;
+
+        /**
+         *  @brief Maps a file written by MappedHashTableWriter, replacing any file mapped before.
+         *  @param path The path of the file.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if the file could not be mapped or is not a valid MappedHashTable
+         *  file. The MappedHashTable is left empty.
+         */
+        bool open(const string &path)
+        {
+            typedef MappedHashTableFormat Format;
+
+            close();
+
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0)
+                return false;
+
+            struct stat status;
+            if (fstat(descriptor, &status) || static_cast<uint64_t>(status.st_size) < sizeof(Format::Header))
+            {
+                ::close(descriptor);
+                return false;
+            }
+
+            void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+            ::close(descriptor);
+
+            if (mapping == MAP_FAILED)
+                return false;
+
+            mMapping = mapping;
+            mMappingSize = status.st_size;
+
+            const Format::Header *header = static_cast<const Format::Header *>(mapping);
+            uint64_t size = mMappingSize;
+
+            bool valid = !memcmp(header->magic, Format::MAGIC, sizeof(header->magic)) &&
+                         header->version == Format::VERSION && header->byteOrder == Format::BYTE_ORDER_MARK &&
+                         header->capacity && !(header->capacity & (header->capacity - 1)) &&
+                         header->size <= header->capacity && !(header->bucketsOffset % alignof(Format::Bucket)) &&
+                         header->bucketsOffset <= size &&
+                         header->capacity <= (size - header->bucketsOffset) / sizeof(Format::Bucket) &&
+                         header->poolOffset <= size && header->poolSize <= size - header->poolOffset;
+
+            if (!valid)
+            {
+                close();
+                return false;
+            }
+
+            mHeader = header;
+            mBuckets = reinterpret_cast<const Format::Bucket *>(static_cast<const char *>(mapping) + header->bucketsOffset);
+            mPool = static_cast<const char *>(mapping) + header->poolOffset;
+            return true;
+        }
+
+        /**
+         *  @brief Unmaps the file, leaving the MappedHashTable empty.
+         */
+        void close(void)
+        {
+            if (mMapping)
+                munmap(mMapping, mMappingSize);
+
+            mMapping = NULL;
+            mMappingSize = 0;
+            mHeader = NULL;
+            mBuckets = NULL;
+            mPool = NULL;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @param value Assigned a view of the value inside the mapping if key is present. It stays
+         *  valid until the file is closed.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool find(string_view key, string_view &value) const
+        {
+            if (!mHeader)
+                return false;
+
+            // The probe is bounded by the capacity, so a damaged file cannot keep it going
+            const MappedHashTableFormat::Bucket *bucket = RobinHood::probe(mBuckets, mHeader->capacity,
+                MappedHashTableFormat::hashKey(key), [this, &key](const MappedHashTableFormat::Bucket &candidate)
+            {
+                string_view stored;
+                return StringArena::view(mPool, mHeader->poolSize, candidate.key, stored) && stored == key;
+            });
+
+            return bucket && StringArena::view(mPool, mHeader->poolSize, bucket->value, value);
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this MappedHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            string_view value;
+            return this->find(key, value);
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this MappedHashTable.
+         *  @param functor A callable accepting two string_views, the key and the value.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t index = 0; mHeader && index < mHeader->capacity; index++)
+            {
+                string_view key, value;
+
+                if (mBuckets[index].distance && StringArena::view(mPool, mHeader->poolSize, mBuckets[index].key, key) &&
+                    StringArena::view(mPool, mHeader->poolSize, mBuckets[index].value, value))
+                    functor(key, value);
+            }
+        }
+
+        /**
+         *  @brief Returns whether or not a file is mapped.
+         *  @return A boolean representing whether or not open() has succeeded since the last close().
+         */
+        bool isOpen(void) const
+        {
+            return mHeader != NULL;
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this MappedHashTable.
+         *  @return The number of keys in the mapped file, or zero if none is mapped.
+         */
+        size_t getSize(void) const
+        {
+            return mHeader ? mHeader->size : 0;
+        }
+
+        /**
+         *  @brief Returns the number of Buckets in this MappedHashTable.
+         *  @return The capacity of the mapped file, or zero if none is mapped.
+         */
+        size_t getCapacity(void) const
+        {
+            return mHeader ? mHeader->capacity : 0;
+        }
+
+    // Private Members
+    private:
+        //! The start of the mapping. NULL if no file is mapped.
+        void *mMapping;
+        //! The number of bytes mapped.
+        size_t mMappingSize;
+        //! The Header at the start of the mapping. NULL if no valid file is mapped.
+        const MappedHashTableFormat::Header *mHeader;
+        //! The Bucket array inside the mapping.
+        const MappedHashTableFormat::Bucket *mBuckets;
+        //! The string pool inside the mapping.
+        const char *mPool;
+};
+#endif // _INCLUDE_MAPPEDHASHTABLE_H_
@@ -0,0 +1,214 @@
+/**
+ *  @file OwningHashTable.h
+ *  @brief Declaration for a string keyed HashTable that stores its values itself.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_OWNINGHASHTABLE_H_
+#define _INCLUDE_OWNINGHASHTABLE_H_
+
+#include <string>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+#include "Arena.h"
+#include "HashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed HashTable mapping string keys to values of storedType that it owns.
+ *  @param storedType The type of the values stored in our OwningHashTable.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail Values are constructed in place by emplace() inside an ObjectArena belonging to the
+ *  table, and the HashTable underneath only points at them. An insert therefore costs no
+ *  allocation of its own beyond the arena occasionally taking another block, values never move
+ *  while the table grows, and everything is released together with the table.
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class OwningHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of Buckets to start with. It is rounded up to a
+         *  power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        OwningHashTable(const size_t &initialCapacity = 16) : mTable(initialCapacity)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Destroys every value.
+         */
+        ~OwningHashTable(void)
+        {
+            ObjectArena<storedType> &values = mValues;
+            mTable.forEach([&values](const string &, storedType *value) { values.destroy(value); });
+        }
+
+        OwningHashTable(const OwningHashTable<storedType, hasherType> &) = delete;
+        OwningHashTable<storedType, hasherType>& operator =(const OwningHashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Constructs a value from arguments and stores it under key, destroying any value
+         *  already stored for key.
+         *  @param key The key to store the value under.
+         *  @param arguments The arguments to pass to the constructor of storedType.
+         *  @return A reference to the new value. It stays valid until key is removed or replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the Bucket array or the arena. Anything thrown by the
+         *  constructor of storedType is passed on. Either way the OwningHashTable is unchanged.
+         */
+        template <typename... argumentTypes>
+        storedType &emplace(string_view key, argumentTypes&&... arguments)
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+            storedType *previous = mTable.findHashed(key, hash);
+            storedType *value = mValues.create(std::forward<argumentTypes>(arguments)...);
+
+            try
+            {
+                mTable.addHashed(key, value, hash);
+            }
+            catch (...)
+            {
+                mValues.destroy(value);
+                throw;
+            }
+
+            if (previous)
+                mValues.destroy(previous);
+
+            return *value;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        storedType *find(string_view key) const
+        {
+            return mTable.find(key);
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this OwningHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return mTable.contains(key);
+        }
+
+        /**
+         *  @brief Removes key from this OwningHashTable and destroys its value.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            uint32_t hash = HashTable<storedType, hasherType>::hashKey(key.data(), key.size());
+            storedType *value = mTable.findHashed(key, hash);
+
+            if (!value)
+                return false;
+
+            mTable.removeHashed(key, hash);
+            mValues.destroy(value);
+            return true;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this OwningHashTable.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note The OwningHashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            mTable.forEach(functor);
+        }
+
+        /**
+         *  @brief Finishes any pending migration of the underlying HashTable, after which find()
+         *  may be called from several threads at once until the next change.
+         */
+        void completeMigration(void)
+        {
+            mTable.completeMigration();
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this OwningHashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mTable.getSize();
+        }
+
+        /**
+         *  @brief Returns a summary of the state of the underlying HashTable. The values are owned
+         *  here, so unlike for a plain HashTable their bytes are part of totalBytes.
+         *  @return The Statistics of the table.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the probe length histogram.
+         */
+        typename HashTable<storedType, hasherType>::Statistics getStatistics(void) const
+        {
+            typename HashTable<storedType, hasherType>::Statistics result = mTable.getStatistics();
+
+            result.valueBytes = mValues.getCapacity() * sizeof(storedType);
+            result.totalBytes += result.valueBytes;
+            return result;
+        }
+
+        /**
+         *  @brief Returns the number of Buckets in this OwningHashTable.
+         *  @return The current capacity.
+         */
+        size_t getCapacity(void) const
+        {
+            return mTable.getCapacity();
+        }
+
+        /**
+         *  @brief Returns whether or not this OwningHashTable is empty.
+         *  @return A boolean representing whether or not this OwningHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mTable.isEmpty();
+        }
+
+        /**
+         *  @brief Stream insertion operator to put an OwningHashTable into a stream. Every value
+         *  is written on its own line.
+         *  @param stream The std::ostream to write into.
+         *  @param input The OwningHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const OwningHashTable<storedType, hasherType> &input)
+        {
+            stream << input.mTable;
+            return stream;
+        }
+
+    // Private Members
+    private:
+        //! Maps the keys to the values in mValues.
+        HashTable<storedType, hasherType> mTable;
+        //! Holds the values.
+        ObjectArena<storedType> mValues;
+};
+#endif // _INCLUDE_OWNINGHASHTABLE_H_
@@ -0,0 +1,209 @@
+/**
+ *  @file OwningKeyedHashTable.h
+ *  @brief Declaration for a KeyedHashTable that stores its values itself.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_OWNINGKEYEDHASHTABLE_H_
+#define _INCLUDE_OWNINGKEYEDHASHTABLE_H_
+
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+#include "Arena.h"
+#include "KeyedHashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed table of values of storedType that it owns, looked up by a string
+ *  key that each value carries itself.
+ *  @param storedType The type of the values stored in our OwningKeyedHashTable.
+ *  @param keyExtractor A default constructible callable that accepts a const storedType & and
+ *  returns its key, such as MemberKey.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail This is OwningHashTable over a KeyedHashTable: values are constructed in place by
+ *  emplace() inside an ObjectArena and the KeyedHashTable underneath reads their keys out of them,
+ *  so each key is stored once, inside its value, rather than once there and again in a Bucket.
+ */
+template <typename storedType, typename keyExtractor, typename hasherType = FNV1aHasher>
+class OwningKeyedHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of Buckets to start with. It is rounded up to a
+         *  power of two.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the Bucket array.
+         */
+        OwningKeyedHashTable(const size_t &initialCapacity = 16) : mTable(initialCapacity)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Destroys every value.
+         */
+        ~OwningKeyedHashTable(void)
+        {
+            ObjectArena<storedType> &values = mValues;
+            mTable.forEach([&values](storedType *value) { values.destroy(value); });
+        }
+
+        OwningKeyedHashTable(const OwningKeyedHashTable<storedType, keyExtractor, hasherType> &) = delete;
+        OwningKeyedHashTable<storedType, keyExtractor, hasherType>& operator =(const OwningKeyedHashTable<storedType, keyExtractor, hasherType> &) = delete;
+
+        /**
+         *  @brief Constructs a value from arguments and stores it under its own key, destroying any
+         *  value already stored with an equal key.
+         *  @param arguments The arguments to pass to the constructor of storedType.
+         *  @return A reference to the new value. It stays valid until its key is removed or replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the Bucket array or the arena. Anything thrown by the
+         *  constructor of storedType is passed on. Either way the OwningKeyedHashTable is unchanged.
+         */
+        template <typename... argumentTypes>
+        storedType &emplace(argumentTypes&&... arguments)
+        {
+            storedType *value = mValues.create(std::forward<argumentTypes>(arguments)...);
+            storedType *previous = mTable.find(mExtractor(*value));
+
+            try
+            {
+                mTable.add(value);
+            }
+            catch (...)
+            {
+                mValues.destroy(value);
+                throw;
+            }
+
+            if (previous)
+                mValues.destroy(previous);
+
+            return *value;
+        }
+
+        /**
+         *  @brief Looks up the value whose key equals key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value with that key, or NULL if there is none.
+         *  @note This only reads, so any number of threads may call it at once as long as nothing
+         *  modifies the OwningKeyedHashTable meanwhile.
+         */
+        storedType *find(string_view key) const
+        {
+            return mTable.find(key);
+        }
+
+        /**
+         *  @brief Returns whether or not a value with key is present in this OwningKeyedHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return mTable.contains(key);
+        }
+
+        /**
+         *  @brief Removes the value whose key equals key and destroys it.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            storedType *value = mTable.find(key);
+
+            if (!value)
+                return false;
+
+            mTable.remove(key);
+            mValues.destroy(value);
+            return true;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this OwningKeyedHashTable.
+         *  @param functor A callable accepting the key as keyExtractor returns it, such as a
+         *  const string & for MemberKey, and a storedType *.
+         *  @note The OwningKeyedHashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            const keyExtractor &extractor = mExtractor;
+            mTable.forEach([&functor, &extractor](storedType *value) { functor(extractor(*value), value); });
+        }
+
+        /**
+         *  @brief Returns the number of values stored in this OwningKeyedHashTable.
+         *  @return The number of values currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mTable.getSize();
+        }
+
+        /**
+         *  @brief Returns a summary of the state of the underlying KeyedHashTable. The values are
+         *  owned here, so their bytes are part of totalBytes.
+         *  @return The Statistics of the table.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the probe length histogram.
+         */
+        typename KeyedHashTable<storedType, keyExtractor, hasherType>::Statistics getStatistics(void) const
+        {
+            typename KeyedHashTable<storedType, keyExtractor, hasherType>::Statistics result = mTable.getStatistics();
+
+            result.valueBytes = mValues.getCapacity() * sizeof(storedType);
+            result.totalBytes += result.valueBytes;
+            return result;
+        }
+
+        /**
+         *  @brief Returns the number of Buckets in this OwningKeyedHashTable.
+         *  @return The current capacity.
+         */
+        size_t getCapacity(void) const
+        {
+            return mTable.getCapacity();
+        }
+
+        /**
+         *  @brief Returns whether or not this OwningKeyedHashTable is empty.
+         *  @return A boolean representing whether or not this OwningKeyedHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mTable.isEmpty();
+        }
+
+        /**
+         *  @brief Stream insertion operator to put an OwningKeyedHashTable into a stream. Every
+         *  value is written on its own line.
+         *  @param stream The std::ostream to write into.
+         *  @param input The OwningKeyedHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const OwningKeyedHashTable<storedType, keyExtractor, hasherType> &input)
+        {
+            stream << input.mTable;
+            return stream;
+        }
+
+    // Private Members
+    private:
+        //! Reads the key out of a value.
+        keyExtractor mExtractor;
+        //! Finds the values in mValues by their keys.
+        KeyedHashTable<storedType, keyExtractor, hasherType> mTable;
+        //! Holds the values.
+        ObjectArena<storedType> mValues;
+};
+#endif // _INCLUDE_OWNINGKEYEDHASHTABLE_H_
@@ -0,0 +1,1034 @@
+/**
+ *  @file PersistentHashTable.h
+ *  @brief Declaration for a string keyed hash table whose snapshots are taken in constant time
+ *  and stay frozen while the table keeps changing.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_PERSISTENTHASHTABLE_H_
+#define _INCLUDE_PERSISTENTHASHTABLE_H_
+
+#include <map>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+#include "Hashers.h"
+
+using namespace std;
+
+/**
+ *  @brief A hash array mapped trie mapping string keys to pointers of storedType, from which
+ *  frozen Snapshots can be taken in constant time.
+ *  @param storedType The type of the values to point to in our PersistentHashTable.
+ *  @param hasherType The hash function, as for HashTable.
+ *  @detail Each level of the trie consumes five bits of the 64 bit hash. A Node keeps one bitmap
+ *  of the fragments stored inline as leaves and another of the fragments leading to child Nodes,
+ *  with both arrays packed in fragment order, so a lookup is a popcount and an index per level.
+ *  Keys whose hashes agree in all 64 bits share a Node below the last level and are compared one
+ *  by one.
+ *
+ *  Every Node records the version of the table it was made in, and the first change after a
+ *  snapshot() starts a new version. No Snapshot can hold a Node of the current version, nor any
+ *  Node while no Snapshot is alive, so those are changed in place and adds and removals between
+ *  Snapshots cost what they would in any trie. snapshot() only records the version it was taken
+ *  at. The next change after it copies the Nodes on the path it touches and shares every other
+ *  Node, and the Snapshot never sees that change. Keys are immutable and shared between the
+ *  copies of a Leaf, so copying a Node is one allocation and a copy of pointers that touches
+ *  neither its children nor its keys. Nothing is reference counted: whatever a change stops
+ *  using is retired with the range of versions whose Snapshots may still hold it, and freed
+ *  once the last Snapshot in that range is destroyed. Removal folds a child left with one leaf
+ *  back into its parent, so the trie stays as shallow as its keys require.
+ *  @note The PersistentHashTable does not own the values it points to, and they must outlive
+ *  every Snapshot that holds them. The table itself, including snapshot(), must only be used by
+ *  one thread at a time, but a Snapshot never changes, so any thread may read, copy or destroy
+ *  one while the table goes on being modified.
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class PersistentHashTable
+{
+    // Private Members
+    private:
+        struct Node;
+        struct Registry;
+
+    // Public Methods
+    public:
+        /**
+         *  @brief A frozen view of a PersistentHashTable, as it was when snapshot() was called.
+         *  @detail Copying a Snapshot is as cheap as taking it, and the Nodes it holds are freed
+         *  once neither the table nor any Snapshot uses them.
+         */
+        class Snapshot
+        {
+            // Public Methods
+            public:
+                /**
+                 *  @brief Copy constructor. Both Snapshots share the same Nodes.
+                 *  @param source The Snapshot to copy.
+                 */
+                Snapshot(const Snapshot &source) : mRoot(source.mRoot), mSize(source.mSize), mVersion(source.mVersion),
+                mRegistry(source.mRegistry)
+                {
+                    attach(mRegistry, mVersion);
+                }
+
+                /**
+                 *  @brief Standard destructor.
+                 */
+                ~Snapshot(void)
+                {
+                    detach(mRegistry, mVersion);
+                }
+
+                /**
+                 *  @brief Copy assignment operator. Both Snapshots share the same Nodes.
+                 *  @param source The Snapshot to copy.
+                 *  @return A reference to this Snapshot.
+                 */
+                Snapshot &operator =(const Snapshot &source)
+                {
+                    attach(source.mRegistry, source.mVersion);
+                    detach(mRegistry, mVersion);
+
+                    mRoot = source.mRoot;
+                    mSize = source.mSize;
+                    mVersion = source.mVersion;
+                    mRegistry = source.mRegistry;
+                    return *this;
+                }
+
+                /**
+                 *  @brief Looks up the value stored for key when the Snapshot was taken.
+                 *  @param key The key to look up.
+                 *  @return A pointer to the value stored for key, or NULL if key was not present.
+                 */
+                storedType *find(string_view key) const
+                {
+                    return findIn(mRoot, key, hasherType::hash(key.data(), key.size()));
+                }
+
+                /**
+                 *  @brief Returns whether or not key was present when the Snapshot was taken.
+                 *  @param key The key to look for.
+                 *  @return A boolean representing whether or not key is present.
+                 */
+                bool contains(string_view key) const
+                {
+                    return this->find(key) != NULL;
+                }
+
+                /**
+                 *  @brief Calls functor with every key and value pair in this Snapshot.
+                 *  @param functor A callable accepting a const string & and a storedType *.
+                 */
+                template <typename functorType>
+                void forEach(functorType functor) const
+                {
+                    forEachIn(mRoot, functor);
+                }
+
+                /**
+                 *  @brief Returns the number of keys in this Snapshot.
+                 *  @return The number of keys.
+                 */
+                size_t getSize(void) const
+                {
+                    return mSize;
+                }
+
+                /**
+                 *  @brief Returns whether or not this Snapshot is empty.
+                 *  @return A boolean representing whether or not this Snapshot is empty.
+                 */
+                bool isEmpty(void) const
+                {
+                    return mSize == 0;
+                }
+
+                /**
+                 *  @brief Stream insertion operator to put a Snapshot into a stream. Every value is
+                 *  written on its own line, in trie order.
+                 *  @param stream The std::ostream to write into.
+                 *  @param input The Snapshot to write into the stream.
+                 *  @return A reference to the input stream.
+                 */
+                friend ostream& operator <<(ostream &stream, const Snapshot &input)
+                {
+                    bool first = true;
+
+                    input.forEach([&stream, &first](const string &, storedType *value)
+                    {
+                        if (!first)
+                            stream << "\n";
+
+                        stream << *value;
+                        first = false;
+                    });
+
+                    return stream;
+                }
+
+            // Private Members
+            private:
+                friend class PersistentHashTable<storedType, hasherType>;
+
+                //! The root of the trie as it was when the Snapshot was taken.
+                Node *mRoot;
+                //! The number of keys in the trie.
+                size_t mSize;
+                //! The version of the table the Snapshot was taken at.
+                uint64_t mVersion;
+                //! The record of live Snapshots, shared with the table.
+                Registry *mRegistry;
+
+            // Private Methods
+            private:
+                /**
+                 *  @brief Constructor recording a new Snapshot of a root.
+                 *  @param root The root to hold.
+                 *  @param size The number of keys under root.
+                 *  @param version The version of the table root belongs to.
+                 *  @param registry The record of live Snapshots of the table.
+                 *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+                 *  the heap to record the Snapshot.
+                 */
+                Snapshot(Node *root, const size_t &size, const uint64_t &version, Registry *registry) : mRoot(root),
+                mSize(size), mVersion(version), mRegistry(registry)
+                {
+                    attach(mRegistry, mVersion);
+                }
+        };
+
+        /**
+         *  @brief Parameterless Constructor.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the root.
+         */
+        PersistentHashTable(void) : mSize(0), mVersion(0), mFrozen(false)
+        {
+            mRegistry = new Registry();
+
+            try
+            {
+                mRoot = new Node(mVersion);
+            }
+            catch (...)
+            {
+                delete mRegistry;
+                throw;
+            }
+        }
+
+        /**
+         *  @brief Standard destructor. Snapshots taken from this table remain valid.
+         */
+        ~PersistentHashTable(void)
+        {
+            {
+                lock_guard<mutex> guard(mRegistry->lock);
+
+                // The last Snapshot to go frees the trie along with the Registry
+                if (!mRegistry->versions.empty())
+                {
+                    mRegistry->orphan = mRoot;
+                    return;
+                }
+            }
+
+            destroy(mRoot);
+            delete mRegistry;
+        }
+
+        PersistentHashTable(const PersistentHashTable<storedType, hasherType> &) = delete;
+        PersistentHashTable<storedType, hasherType>& operator =(const PersistentHashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap. The contents of the PersistentHashTable are unchanged.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            beginChange();
+            mRoot = own(mRoot);
+
+            if (!insertInto(mRoot, key, value, hasherType::hash(key.data(), key.size()), 0))
+                return false;
+
+            ++mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        storedType *find(string_view key) const
+        {
+            return findIn(mRoot, key, hasherType::hash(key.data(), key.size()));
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this PersistentHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes key and its value from this PersistentHashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for copies of Nodes held by a Snapshot. The contents of the
+         *  PersistentHashTable are unchanged.
+         */
+        bool remove(string_view key)
+        {
+            uint64_t hash = hasherType::hash(key.data(), key.size());
+
+            // Looking first means a miss never copies Nodes a Snapshot holds
+            if (!findIn(mRoot, key, hash))
+                return false;
+
+            beginChange();
+            mRoot = own(mRoot);
+            removeFrom(mRoot, key, hash, 0);
+
+            --mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Removes every key from this PersistentHashTable. Snapshots taken earlier keep
+         *  their keys.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new root. The PersistentHashTable is unchanged.
+         */
+        void clear(void)
+        {
+            beginChange();
+            Node *root = new Node(mVersion);
+
+            Retired trie;
+            trie.first = 0;
+            trie.node = mRoot;
+            trie.key = NULL;
+            trie.wholeTrie = true;
+            retire(trie);
+
+            mRoot = root;
+            mSize = 0;
+        }
+
+        /**
+         *  @brief Takes a frozen view of the current contents, in constant time.
+         *  @return A Snapshot of this PersistentHashTable.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap to record the Snapshot.
+         */
+        Snapshot snapshot(void) const
+        {
+            // The Nodes of this version may now be held, so the next change has to start another
+            mFrozen = true;
+            return Snapshot(mRoot, mSize, mVersion, mRegistry);
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this PersistentHashTable.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note The PersistentHashTable must not be modified while this is running; iterate a
+         *  snapshot() when it has to be.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            forEachIn(mRoot, functor);
+        }
+
+        /**
+         *  @brief Returns the number of keys in this PersistentHashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns whether or not this PersistentHashTable is empty.
+         *  @return A boolean representing whether or not this PersistentHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a PersistentHashTable into a stream. Every
+         *  value is written on its own line, in trie order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The PersistentHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const PersistentHashTable<storedType, hasherType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](const string &, storedType *value)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << *value;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        //! The number of hash bits each level of the trie consumes.
+        static constexpr unsigned int BITS_PER_LEVEL = 5;
+        //! Selects one level's fragment of a hash.
+        static constexpr uint64_t FRAGMENT_MASK = (1 << BITS_PER_LEVEL) - 1;
+        //! The number of bits in a hash. Nodes this deep hold keys whose hashes are all equal.
+        static constexpr unsigned int HASH_BITS = 64;
+
+        /**
+         *  A stored key. It never changes, so every copy of the Leaf holding it shares it.
+         */
+        struct Key
+        {
+            //! The version of the table the key was added in.
+            uint64_t version;
+            //! The characters of the key.
+            const string text;
+
+            Key(string_view text, const uint64_t &version) : version(version), text(text)
+            {
+
+            }
+        };
+
+        /**
+         *  A key and the value stored for it.
+         */
+        struct Leaf
+        {
+            //! The key, shared with every copy of this Leaf.
+            Key *key;
+            //! The value stored for key.
+            storedType *value;
+            //! The full hash of key, so that pushing the Leaf down a level needs no rehash.
+            uint64_t hash;
+
+            Leaf(Key *key, storedType *value, const uint64_t &hash) : key(key), value(value), hash(hash)
+            {
+
+            }
+        };
+
+        /**
+         *  A Node of the trie.
+         */
+        struct Node
+        {
+            //! The version of the table the Node was made in.
+            uint64_t version;
+            //! The fragments stored as a Leaf of this Node.
+            uint32_t leafMap;
+            //! The fragments leading to a child Node.
+            uint32_t childMap;
+            //! The Leaves, in fragment order. Below the last level, every key with this hash.
+            vector<Leaf> leaves;
+            //! The children, in fragment order.
+            vector<Node *> children;
+
+            Node(const uint64_t &version) : version(version), leafMap(0), childMap(0)
+            {
+
+            }
+
+            //! Copies source for a change a Snapshot must not see. The copy shares its children and keys.
+            Node(const Node &source, const uint64_t &version) : version(version), leafMap(source.leafMap),
+            childMap(source.childMap), leaves(source.leaves), children(source.children)
+            {
+
+            }
+        };
+
+        /**
+         *  Something the table stopped using while a Snapshot may still hold it.
+         */
+        struct Retired
+        {
+            //! The oldest version whose Snapshots may hold it.
+            uint64_t first;
+            //! The version that stopped using it. Snapshots taken at it or later never hold it.
+            uint64_t last;
+            //! The Node, or NULL.
+            Node *node;
+            //! The key, or NULL.
+            Key *key;
+            //! Whether node is the root of a trie to be freed along with every Node and key in it.
+            bool wholeTrie;
+        };
+
+        /**
+         *  The record of which Snapshots are alive, shared by the table and its Snapshots and freed
+         *  by whichever of them goes last.
+         */
+        struct Registry
+        {
+            Registry(void) : snapshots(0), orphan(NULL)
+            {
+
+            }
+
+            //! Frees everything still retired and the trie the table left behind.
+            ~Registry(void)
+            {
+                for (size_t index = 0; index < retired.size(); index++)
+                    release(retired[index]);
+
+                if (orphan)
+                    destroy(orphan);
+            }
+
+            //! Guards every other member.
+            mutex lock;
+            //! The number of live Snapshots taken at each version.
+            map<uint64_t, size_t> versions;
+            //! The number of live Snapshots, which the table reads without taking the lock.
+            atomic<size_t> snapshots;
+            //! Everything retired that a live Snapshot may still hold, oldest first.
+            vector<Retired> retired;
+            //! The trie of the table once the table is destroyed, NULL until then.
+            Node *orphan;
+        };
+
+        //! The root of the trie. Unlike other Nodes, it may hold fewer than two keys.
+        Node *mRoot;
+        //! The number of keys in the trie.
+        size_t mSize;
+        //! The version Nodes made now belong to.
+        uint64_t mVersion;
+        //! Whether a Snapshot was taken at mVersion, so the next change has to start a new one.
+        mutable bool mFrozen;
+        //! The record of live Snapshots.
+        Registry *mRegistry;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Returns the position of a fragment within a packed array.
+         *  @param map The bitmap of the array.
+         *  @param bit The bit of the fragment.
+         *  @return The number of fragments before bit in map.
+         */
+        static size_t indexOf(const uint32_t &map, const uint32_t &bit)
+        {
+            return __builtin_popcount(map & (bit - 1));
+        }
+
+        /**
+         *  @brief Returns the bit of the fragment of hash at a level.
+         *  @param hash The hash.
+         *  @param shift The number of hash bits consumed by the levels above.
+         *  @return The bit of the fragment.
+         */
+        static uint32_t bitOf(const uint64_t &hash, const unsigned int &shift)
+        {
+            return static_cast<uint32_t>(1) << ((hash >> shift) & FRAGMENT_MASK);
+        }
+
+        /**
+         *  @brief Records a new Snapshot.
+         *  @param registry The record of live Snapshots.
+         *  @param version The version the Snapshot was taken at.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the first Snapshot of version. Copies never allocate.
+         */
+        static void attach(Registry *registry, const uint64_t &version)
+        {
+            lock_guard<mutex> guard(registry->lock);
+
+            ++registry->versions[version];
+            registry->snapshots.fetch_add(1, memory_order_relaxed);
+        }
+
+        /**
+         *  @brief Forgets a destroyed Snapshot, freeing whatever no live Snapshot holds anymore.
+         *  @param registry The record of live Snapshots. It is freed if the table and every other
+         *  Snapshot are gone.
+         *  @param version The version the Snapshot was taken at.
+         */
+        static void detach(Registry *registry, const uint64_t &version)
+        {
+            bool last;
+
+            {
+                lock_guard<mutex> guard(registry->lock);
+                typename map<uint64_t, size_t>::iterator entry = registry->versions.find(version);
+
+                if (!--entry->second)
+                {
+                    registry->versions.erase(entry);
+                    collect(*registry);
+                }
+
+                // Release pairs with isShared(), so the table only changes in place what this Snapshot is done reading
+                registry->snapshots.fetch_sub(1, memory_order_release);
+                last = registry->orphan && registry->versions.empty();
+            }
+
+            if (last)
+                delete registry;
+        }
+
+        /**
+         *  @brief Returns whether or not a live Snapshot was taken at any of a range of versions.
+         *  The lock of registry must be held.
+         *  @param registry The record of live Snapshots.
+         *  @param first The first version of the range.
+         *  @param last The version past the end of the range.
+         *  @return A boolean representing whether or not such a Snapshot exists.
+         */
+        static bool isHeld(const Registry &registry, const uint64_t &first, const uint64_t &last)
+        {
+            typename map<uint64_t, size_t>::const_iterator entry = registry.versions.lower_bound(first);
+            return entry != registry.versions.end() && entry->first < last;
+        }
+
+        /**
+         *  @brief Frees everything retired that no live Snapshot holds anymore. The lock of
+         *  registry must be held.
+         *  @param registry The record of live Snapshots.
+         */
+        static void collect(Registry &registry)
+        {
+            size_t kept = 0;
+
+            for (size_t index = 0; index < registry.retired.size(); index++)
+            {
+                if (isHeld(registry, registry.retired[index].first, registry.retired[index].last))
+                    registry.retired[kept++] = registry.retired[index];
+                else
+                    release(registry.retired[index]);
+            }
+
+            registry.retired.resize(kept);
+        }
+
+        /**
+         *  @brief Frees something that was retired.
+         *  @param item What to free.
+         */
+        static void release(const Retired &item)
+        {
+            if (item.wholeTrie)
+                destroy(item.node);
+            else
+                delete item.node;
+
+            delete item.key;
+        }
+
+        /**
+         *  @brief Frees a trie, with every Node and key in it.
+         *  @param node The root of the trie.
+         */
+        static void destroy(Node *node)
+        {
+            for (Leaf &leaf : node->leaves)
+                delete leaf.key;
+
+            for (Node *child : node->children)
+                destroy(child);
+
+            delete node;
+        }
+
+        /**
+         *  @brief Returns whether or not any Snapshot is alive, in which case Nodes of older
+         *  versions may be held by one.
+         *  @return A boolean representing whether or not a Snapshot is alive.
+         */
+        bool isShared(void) const
+        {
+            return mRegistry->snapshots.load(memory_order_acquire) != 0;
+        }
+
+        /**
+         *  @brief Starts a new version if a Snapshot was taken at the current one. Called before
+         *  every change.
+         */
+        void beginChange(void)
+        {
+            if (mFrozen)
+            {
+                ++mVersion;
+                mFrozen = false;
+            }
+        }
+
+        /**
+         *  @brief Hands over something the table stopped using, freeing it right away unless a
+         *  live Snapshot may hold it.
+         *  @param item What the table stopped using. Its last version is filled in here.
+         */
+        void retire(Retired item)
+        {
+            item.last = mVersion;
+
+            if (item.first < item.last && isShared())
+            {
+                lock_guard<mutex> guard(mRegistry->lock);
+
+                if (isHeld(*mRegistry, item.first, item.last))
+                {
+                    try
+                    {
+                        mRegistry->retired.push_back(item);
+                    }
+                    catch (const bad_alloc &)
+                    {
+                        // A Snapshot may still read it, so leaking it is the only safe choice left
+                    }
+
+                    return;
+                }
+            }
+
+            release(item);
+        }
+
+        /**
+         *  @brief Retires a Node the table stopped using.
+         *  @param node The Node.
+         */
+        void retire(Node *node)
+        {
+            Retired item;
+            item.first = node->version;
+            item.node = node;
+            item.key = NULL;
+            item.wholeTrie = false;
+            retire(item);
+        }
+
+        /**
+         *  @brief Retires a key the table stopped using.
+         *  @param key The key.
+         */
+        void retire(Key *key)
+        {
+            Retired item;
+            item.first = key->version;
+            item.node = NULL;
+            item.key = key;
+            item.wholeTrie = false;
+            retire(item);
+        }
+
+        /**
+         *  @brief Makes a Node safe to change, copying it if a Snapshot may hold it.
+         *  @param node The Node to change.
+         *  @return node itself, or a copy of it that only the table holds, in which case node
+         *  has been retired.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the copy. node is unchanged.
+         */
+        Node *own(Node *node)
+        {
+            if (node->version == mVersion || !isShared())
+                return node;
+
+            Node *result = new Node(*node, mVersion);
+            retire(node);
+            return result;
+        }
+
+        /**
+         *  @brief Looks up key in the trie under node.
+         *  @param node The root of the trie.
+         *  @param key The key to look up.
+         *  @param hash The hash of key.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        static storedType *findIn(const Node *node, string_view key, const uint64_t &hash)
+        {
+            for (unsigned int shift = 0; shift < HASH_BITS; shift += BITS_PER_LEVEL)
+            {
+                uint32_t bit = bitOf(hash, shift);
+
+                if (node->leafMap & bit)
+                {
+                    const Leaf &leaf = node->leaves[indexOf(node->leafMap, bit)];
+                    return leaf.hash == hash && leaf.key->text == key ? leaf.value : NULL;
+                }
+
+                if (!(node->childMap & bit))
+                    return NULL;
+
+                node = node->children[indexOf(node->childMap, bit)];
+            }
+
+            for (const Leaf &leaf : node->leaves)
+                if (leaf.key->text == key)
+                    return leaf.value;
+
+            return NULL;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in the trie under node.
+         *  @param node The root of the trie.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         */
+        template <typename functorType>
+        static void forEachIn(const Node *node, functorType &functor)
+        {
+            for (const Leaf &leaf : node->leaves)
+                functor(leaf.key->text, leaf.value);
+
+            for (const Node *child : node->children)
+                forEachIn(child, functor);
+        }
+
+        /**
+         *  @brief Builds the subtrie holding two Leaves with different keys.
+         *  @param first The first Leaf.
+         *  @param second The second Leaf.
+         *  @param shift The number of hash bits consumed by the levels above.
+         *  @return A new Node holding both Leaves.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap. Nothing is leaked.
+         */
+        Node *split(const Leaf &first, const Leaf &second, const unsigned int &shift)
+        {
+            Node *result = new Node(mVersion);
+
+            try
+            {
+                if (shift >= HASH_BITS)
+                {
+                    result->leaves.reserve(2);
+                    result->leaves.push_back(first);
+                    result->leaves.push_back(second);
+                }
+                else if (bitOf(first.hash, shift) != bitOf(second.hash, shift))
+                {
+                    bool ordered = bitOf(first.hash, shift) < bitOf(second.hash, shift);
+
+                    result->leafMap = bitOf(first.hash, shift) | bitOf(second.hash, shift);
+                    result->leaves.reserve(2);
+                    result->leaves.push_back(ordered ? first : second);
+                    result->leaves.push_back(ordered ? second : first);
+                }
+                else
+                {
+                    result->childMap = bitOf(first.hash, shift);
+                    result->children.reserve(1);
+                    result->children.push_back(split(first, second, shift + BITS_PER_LEVEL));
+                }
+            }
+            catch (...)
+            {
+                // Only the reservations can throw, so result holds nothing yet and the keys stay with the caller
+                delete result;
+                throw;
+            }
+
+            return result;
+        }
+
+        /**
+         *  @brief Associates value with key in the subtrie under a Node only the table holds.
+         *  @param node The Node to add under.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @param hash The hash of key.
+         *  @param shift The number of hash bits consumed by the levels above.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap. The keys under node are unchanged.
+         */
+        bool insertInto(Node *node, string_view key, storedType *value, const uint64_t &hash,
+                        const unsigned int &shift)
+        {
+            if (shift >= HASH_BITS)
+            {
+                for (Leaf &leaf : node->leaves)
+                {
+                    if (leaf.key->text == key)
+                    {
+                        leaf.value = value;
+                        return false;
+                    }
+                }
+
+                Leaf added(new Key(key, mVersion), value, hash);
+                try
+                {
+                    node->leaves.push_back(added);
+                }
+                catch (...)
+                {
+                    delete added.key;
+                    throw;
+                }
+
+                return true;
+            }
+
+            uint32_t bit = bitOf(hash, shift);
+
+            if (node->childMap & bit)
+            {
+                Node *&child = node->children[indexOf(node->childMap, bit)];
+
+                child = own(child);
+                return insertInto(child, key, value, hash, shift + BITS_PER_LEVEL);
+            }
+
+            size_t index = indexOf(node->leafMap, bit);
+
+            if (!(node->leafMap & bit))
+            {
+                Leaf added(new Key(key, mVersion), value, hash);
+                try
+                {
+                    node->leaves.insert(node->leaves.begin() + index, added);
+                }
+                catch (...)
+                {
+                    delete added.key;
+                    throw;
+                }
+
+                node->leafMap |= bit;
+                return true;
+            }
+
+            Leaf &leaf = node->leaves[index];
+            if (leaf.hash == hash && leaf.key->text == key)
+            {
+                leaf.value = value;
+                return false;
+            }
+
+            // Another key owns this fragment, so both move down into a new child
+            node->children.reserve(node->children.size() + 1);
+
+            Leaf added(new Key(key, mVersion), value, hash);
+            Node *child;
+            try
+            {
+                child = split(leaf, added, shift + BITS_PER_LEVEL);
+            }
+            catch (...)
+            {
+                delete added.key;
+                throw;
+            }
+
+            node->leaves.erase(node->leaves.begin() + index);
+            node->leafMap &= ~bit;
+            node->childMap |= bit;
+            node->children.insert(node->children.begin() + indexOf(node->childMap, bit), child);
+            return true;
+        }
+
+        /**
+         *  @brief Removes a key that is present from the subtrie under a Node only the table
+         *  holds.
+         *  @param node The Node to remove under.
+         *  @param key The key to remove.
+         *  @param hash The hash of key.
+         *  @param shift The number of hash bits consumed by the levels above.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for copies of Nodes held by a Snapshot. The keys under node are unchanged.
+         */
+        void removeFrom(Node *node, string_view key, const uint64_t &hash, const unsigned int &shift)
+        {
+            if (shift >= HASH_BITS)
+            {
+                for (size_t index = 0; index < node->leaves.size(); index++)
+                {
+                    if (node->leaves[index].key->text == key)
+                    {
+                        Key *removed = node->leaves[index].key;
+
+                        node->leaves.erase(node->leaves.begin() + index);
+                        retire(removed);
+                        return;
+                    }
+                }
+
+                return;
+            }
+
+            uint32_t bit = bitOf(hash, shift);
+
+            if (node->leafMap & bit)
+            {
+                size_t index = indexOf(node->leafMap, bit);
+                Key *removed = node->leaves[index].key;
+
+                node->leaves.erase(node->leaves.begin() + index);
+                node->leafMap &= ~bit;
+                retire(removed);
+                return;
+            }
+
+            size_t childIndex = indexOf(node->childMap, bit);
+            Node *&child = node->children[childIndex];
+
+            child = own(child);
+            removeFrom(child, key, hash, shift + BITS_PER_LEVEL);
+
+            if (!child->children.empty() || child->leaves.size() > 1)
+                return;
+
+            // A child left with one Leaf is folded into this Node, and that repeats up the path
+            if (!child->leaves.empty())
+            {
+                try
+                {
+                    node->leaves.insert(node->leaves.begin() + indexOf(node->leafMap, bit), child->leaves.front());
+                }
+                catch (const bad_alloc &)
+                {
+                    // The key is gone either way, and a child holding one Leaf is still valid
+                    return;
+                }
+
+                node->leafMap |= bit;
+            }
+
+            // own() made sure no Snapshot holds the child, and its key now lives in this Node
+            delete child;
+            node->children.erase(node->children.begin() + childIndex);
+            node->childMap &= ~bit;
+        }
+};
+#endif // _INCLUDE_PERSISTENTHASHTABLE_H_
@@ -0,0 +1,521 @@
+/**
+ *  @file PrefixIndex.h
+ *  @brief Declaration for a radix tree of string keys that lists the keys starting with a prefix
+ *  in lexicographic order.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_PREFIXINDEX_H_
+#define _INCLUDE_PREFIXINDEX_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+#include <string_view>
+
+using namespace std;
+
+/**
+ *  @brief A generically typed radix tree mapping string keys to pointers of storedType, kept next
+ *  to a HashTable to answer prefix queries it cannot.
+ *  @param storedType The type of the values to point to in our PrefixIndex.
+ *  @detail Every edge of the tree is labelled with a run of characters and every Node other than
+ *  the root either ends a key or has at least two children, so there are fewer Nodes than twice
+ *  the number of keys however long the keys are. Children are kept sorted by the first character
+ *  of their label, which makes a depth first walk visit keys in lexicographic order. A prefix
+ *  query walks down to the subtree of the prefix in time proportional to its length and then
+ *  visits only Nodes that lead to results, so reporting k keys costs O(prefix length + k * key
+ *  length) regardless of the number of keys in the index.
+ *  @note The PrefixIndex does not own the values it points to, and values may be NULL for keys
+ *  that are only indexed for their spelling.
+ */
+template <typename storedType>
+class PrefixIndex
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Parameter-less constructor.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the root Node.
+         */
+        PrefixIndex(void) : mRoot(new Node()), mSize(0)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~PrefixIndex(void)
+        {
+            destroy(mRoot);
+        }
+
+        PrefixIndex(const PrefixIndex<storedType> &) = delete;
+        PrefixIndex<storedType>& operator =(const PrefixIndex<storedType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store. May be NULL.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for a Node. The PrefixIndex is unchanged.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            Node *node = mRoot;
+            size_t position = 0;
+
+            while (position < key.size())
+            {
+                size_t index = lowerBound(node, key[position]);
+
+                // No edge starts with the next character: the rest of key becomes a new leaf
+                if (index == node->children.size() || node->children[index]->label[0] != key[position])
+                {
+                    Node *leaf = new Node(key.substr(position), value);
+
+                    try
+                    {
+                        node->children.insert(node->children.begin() + index, leaf);
+                    }
+                    catch (...)
+                    {
+                        delete leaf;
+                        throw;
+                    }
+
+                    ++mSize;
+                    return true;
+                }
+
+                Node *child = node->children[index];
+                size_t common = commonLength(child->label, key.substr(position));
+
+                // key leaves the edge part way along it: split the edge where they diverge
+                if (common < child->label.size())
+                {
+                    Node *middle = new Node(string_view(child->label).substr(0, common), NULL);
+
+                    try
+                    {
+                        middle->children.push_back(child);
+                    }
+                    catch (...)
+                    {
+                        delete middle;
+                        throw;
+                    }
+
+                    middle->terminal = false;
+                    child->label.erase(0, common);
+                    node->children[index] = middle;
+                    child = middle;
+                }
+
+                node = child;
+                position += common;
+            }
+
+            bool added = !node->terminal;
+
+            node->terminal = true;
+            node->value = value;
+
+            if (added)
+                ++mSize;
+
+            return added;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value stored for key, or NULL if key is not present or was
+         *  added without a value.
+         */
+        storedType *find(string_view key) const
+        {
+            Node *node = findNode(key);
+            return node ? node->value : NULL;
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this PrefixIndex.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return findNode(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes key and its value from this PrefixIndex.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            Node *parent = NULL;
+            size_t parentIndex = 0;
+            Node *node = mRoot;
+            size_t position = 0;
+
+            while (position < key.size())
+            {
+                size_t index = lowerBound(node, key[position]);
+                if (index == node->children.size())
+                    return false;
+
+                Node *child = node->children[index];
+                if (key.substr(position, child->label.size()) != child->label)
+                    return false;
+
+                parent = node;
+                parentIndex = index;
+                node = child;
+                position += child->label.size();
+            }
+
+            if (!node->terminal)
+                return false;
+
+            node->terminal = false;
+            node->value = NULL;
+            --mSize;
+
+            if (node == mRoot)
+                return true;
+
+            // Restore the invariant that every Node but the root ends a key or branches
+            if (node->children.empty())
+            {
+                delete node;
+                parent->children.erase(parent->children.begin() + parentIndex);
+
+                if (parent != mRoot && !parent->terminal && parent->children.size() == 1)
+                    absorbChild(parent);
+            }
+            else if (node->children.size() == 1)
+                absorbChild(node);
+
+            return true;
+        }
+
+        /**
+         *  @brief Calls functor with every key starting with prefix and its value, in
+         *  lexicographic order, until limit keys have been reported.
+         *  @param prefix The prefix to search for. The empty prefix matches every key.
+         *  @param limit The most keys to report.
+         *  @param functor A callable accepting a const string & and a storedType *. The string is
+         *  only valid during the call.
+         *  @return The number of keys reported.
+         */
+        template <typename functorType>
+        size_t forEachWithPrefix(string_view prefix, const size_t &limit, functorType functor) const
+        {
+            Node *node = mRoot;
+            size_t position = 0;
+            string key;
+
+            while (position < prefix.size())
+            {
+                size_t index = lowerBound(node, prefix[position]);
+                if (index == node->children.size())
+                    return 0;
+
+                // The prefix may end part way along the last edge
+                Node *child = node->children[index];
+                size_t length = prefix.size() - position < child->label.size() ? prefix.size() - position : child->label.size();
+                if (prefix.substr(position, length) != string_view(child->label).substr(0, length))
+                    return 0;
+
+                key += child->label;
+                node = child;
+                position += child->label.size();
+            }
+
+            size_t count = 0;
+            if (limit)
+                collect(node, key, limit, count, functor);
+
+            return count;
+        }
+
+        /**
+         *  @brief Lists the keys starting with prefix and their values, in lexicographic order.
+         *  @param prefix The prefix to search for. The empty prefix matches every key.
+         *  @param limit The most keys to return.
+         *  @return The first limit keys starting with prefix, paired with their values.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the result.
+         */
+        vector<pair<string, storedType *> > prefixSearch(string_view prefix, const size_t &limit) const
+        {
+            vector<pair<string, storedType *> > result;
+
+            forEachWithPrefix(prefix, limit, [&result](const string &key, storedType *value)
+            {
+                result.push_back(make_pair(key, value));
+            });
+
+            return result;
+        }
+
+        /**
+         *  @brief Adds every key and value pair of a table, such as a HashTable or
+         *  OwningHashTable, to this PrefixIndex.
+         *  @param table The table to index. Its forEach() must pass a key and a storedType *.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for a Node. The keys added so far stay.
+         */
+        template <typename tableType>
+        void addAll(const tableType &table)
+        {
+            table.forEach([this](const string &key, storedType *value)
+            {
+                this->add(key, value);
+            });
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this PrefixIndex, in
+         *  lexicographic order.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note The PrefixIndex must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            forEachWithPrefix(string_view(), SIZE_MAX, functor);
+        }
+
+        /**
+         *  @brief Removes every key.
+         */
+        void clear(void)
+        {
+            for (size_t index = 0; index < mRoot->children.size(); index++)
+                destroy(mRoot->children[index]);
+
+            mRoot->children.clear();
+            mRoot->terminal = false;
+            mRoot->value = NULL;
+            mSize = 0;
+        }
+
+        /**
+         *  @brief Returns the number of keys in this PrefixIndex.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns whether or not this PrefixIndex is empty.
+         *  @return A boolean representing whether or not this PrefixIndex is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a PrefixIndex into a stream. Every key is
+         *  written on its own line, in lexicographic order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The PrefixIndex to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const PrefixIndex<storedType> &input)
+        {
+            bool first = true;
+
+            input.forEach([&stream, &first](const string &key, storedType *)
+            {
+                if (!first)
+                    stream << "\n";
+
+                stream << key;
+                first = false;
+            });
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A Node of the radix tree, together with the edge leading to it.
+         */
+        struct Node
+        {
+            /**
+             *  @brief Parameter-less constructor, used for the root.
+             */
+            Node(void) : value(NULL), terminal(false)
+            {
+
+            }
+
+            /**
+             *  @brief Constructor for a Node that ends a key.
+             *  @param label The characters on the edge leading to the Node.
+             *  @param value The value of the key.
+             */
+            Node(string_view label, storedType *value) : label(label), value(value), terminal(true)
+            {
+
+            }
+
+            //! The characters on the edge from the parent to this Node. Empty only for the root.
+            string label;
+            //! The value of the key ending here.
+            storedType *value;
+            //! Whether or not a key ends here.
+            bool terminal;
+            //! The children, sorted by the first character of their label.
+            vector<Node *> children;
+        };
+
+        //! The root, whose edge label is empty.
+        Node *mRoot;
+        //! The number of keys stored.
+        size_t mSize;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Finds the first child of node whose label does not start before character.
+         *  @param node The Node to search the children of.
+         *  @param character The character to search for.
+         *  @return The index of the child, or the number of children if there is none.
+         */
+        static size_t lowerBound(const Node *node, const char &character)
+        {
+            // Compared as unsigned to agree with the ordering of std::string
+            unsigned char target = static_cast<unsigned char>(character);
+            size_t low = 0;
+            size_t high = node->children.size();
+
+            while (low < high)
+            {
+                size_t middle = (low + high) / 2;
+
+                if (static_cast<unsigned char>(node->children[middle]->label[0]) < target)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+
+            return low;
+        }
+
+        /**
+         *  @brief Returns the length of the longest common prefix of two strings.
+         *  @param first The first string.
+         *  @param second The second string.
+         *  @return The number of leading characters the strings share.
+         */
+        static size_t commonLength(string_view first, string_view second)
+        {
+            size_t length = 0;
+
+            while (length < first.size() && length < second.size() && first[length] == second[length])
+                ++length;
+
+            return length;
+        }
+
+        /**
+         *  @brief Finds the Node where key ends.
+         *  @param key The key to look for.
+         *  @return The Node, or NULL if key is not present.
+         */
+        Node *findNode(string_view key) const
+        {
+            Node *node = mRoot;
+            size_t position = 0;
+
+            while (position < key.size())
+            {
+                size_t index = lowerBound(node, key[position]);
+                if (index == node->children.size())
+                    return NULL;
+
+                node = node->children[index];
+                if (key.substr(position, node->label.size()) != node->label)
+                    return NULL;
+
+                position += node->label.size();
+            }
+
+            return node->terminal ? node : NULL;
+        }
+
+        /**
+         *  @brief Merges a Node that neither ends a key nor branches with its only child.
+         *  @param node The Node to merge. It takes the place of the child, so the parent's pointer
+         *  to it stays valid.
+         */
+        static void absorbChild(Node *node)
+        {
+            Node *child = node->children[0];
+
+            node->label += child->label;
+            node->value = child->value;
+            node->terminal = child->terminal;
+            node->children.swap(child->children);
+
+            delete child;
+        }
+
+        /**
+         *  @brief Reports the keys of a subtree in lexicographic order.
+         *  @param node The root of the subtree.
+         *  @param key The key leading to node, which is extended and restored while descending.
+         *  @param limit The most keys to report in total.
+         *  @param count The number of keys reported so far.
+         *  @param functor The callable to report keys to.
+         */
+        template <typename functorType>
+        static void collect(const Node *node, string &key, const size_t &limit, size_t &count, functorType &functor)
+        {
+            if (node->terminal)
+            {
+                functor(static_cast<const string &>(key), node->value);
+                if (++count == limit)
+                    return;
+            }
+
+            for (size_t index = 0; index < node->children.size() && count < limit; index++)
+            {
+                size_t length = key.size();
+                key += node->children[index]->label;
+                collect(node->children[index], key, limit, count, functor);
+                key.resize(length);
+            }
+        }
+
+        /**
+         *  @brief Deletes a subtree.
+         *  @param node The root of the subtree.
+         */
+        static void destroy(Node *node)
+        {
+            for (size_t index = 0; index < node->children.size(); index++)
+                destroy(node->children[index]);
+
+            delete node;
+        }
+};
+#endif // _INCLUDE_PREFIXINDEX_H_
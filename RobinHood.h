@@ -0,0 +1,152 @@
+/**
+ *  @file RobinHood.h
+ *  @brief Declaration for the Robin Hood probing shared by the open addressing HashTables.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_ROBINHOOD_H_
+#define _INCLUDE_ROBINHOOD_H_
+
+#include <stdint.h>
+#include <cstddef>
+
+using namespace std;
+
+/**
+ *  @brief Moves a Bucket by assignment, for Buckets that hold nothing but plain data.
+ */
+struct CopyBucket
+{
+    /**
+     *  @brief Moves the contents of one Bucket into another.
+     *  @param target The empty Bucket to move into.
+     *  @param source The Bucket to move out of.
+     */
+    template <typename bucketType>
+    void operator ()(bucketType &target, bucketType &source) const
+    {
+        target = source;
+    }
+};
+
+/**
+ *  @brief Linear probing with Robin Hood displacement over a power of two sized array of Buckets,
+ *  for any Bucket type with a uint32_t hash and a uint32_t distance.
+ *  @detail distance is one more than the distance from the Bucket the hash selects, its home, and
+ *  zero marks an empty Bucket. Entries are kept so that no probe passes a Bucket closer to its home
+ *  than the probe is to its own, so a lookup for an absent key ends at the first such Bucket.
+ *  claim() keeps that order by shifting the rest of the run up by one Bucket, and erase() by
+ *  shifting it back, so there are no tombstones.
+ *
+ *  Moving an entry between Buckets is left to a relocator, a callable accepting an empty target
+ *  Bucket and a source Bucket, that moves everything but distance across and leaves nothing in
+ *  the source that needs destroying. CopyBucket does for Buckets of plain data.
+ */
+struct RobinHood
+{
+    /**
+     *  @brief Finds the Bucket holding an entry.
+     *  @param buckets The Bucket array to search.
+     *  @param capacity The number of Buckets in the array. Must be a power of two.
+     *  @param hash The hash of the entry.
+     *  @param matches A callable accepting a Bucket whose hash equals hash and returning whether or
+     *  not it holds the entry.
+     *  @return A pointer to the Bucket, or NULL if the entry is not in the array.
+     *  @note Buckets with a distance beyond any real one are stepped over, so a table may flag
+     *  Buckets with its high bits and reject them in matches.
+     */
+    template <typename bucketType, typename matcherType>
+    static bucketType *probe(bucketType *buckets, const size_t &capacity, const uint32_t &hash, matcherType matches)
+    {
+        size_t mask = capacity - 1;
+        size_t current = hash & mask;
+
+        // Bounded by the capacity, so even a damaged array cannot keep the probe going forever
+        for (size_t distance = 1; distance <= capacity; distance++)
+        {
+            bucketType &bucket = buckets[current];
+
+            // An empty Bucket or one closer to home than we are ends the probe sequence
+            if (bucket.distance < distance)
+                return NULL;
+
+            if (bucket.hash == hash && matches(bucket))
+                return &bucket;
+
+            current = (current + 1) & mask;
+        }
+
+        return NULL;
+    }
+
+    /**
+     *  @brief Makes room for an entry that is known not to be present, moving the residents that
+     *  are closer to home than the entry one Bucket further along.
+     *  @param buckets The Bucket array to insert into. It must have an empty Bucket.
+     *  @param capacity The number of Buckets in the array. Must be a power of two.
+     *  @param hash The hash of the entry.
+     *  @param relocate Moves a resident into the empty Bucket after it.
+     *  @return The Bucket the entry goes into, with its hash and distance set. Everything else
+     *  in it is left to the caller to fill in.
+     */
+    template <typename bucketType, typename relocatorType = CopyBucket>
+    static bucketType *claim(bucketType *buckets, const size_t &capacity, const uint32_t &hash,
+                             relocatorType relocate = relocatorType())
+    {
+        size_t mask = capacity - 1;
+        size_t slot = hash & mask;
+        uint32_t distance = 1;
+
+        // The entry belongs in front of the first resident closer to home than it would be
+        for (; buckets[slot].distance >= distance; distance++)
+            slot = (slot + 1) & mask;
+
+        size_t end = slot;
+        while (buckets[end].distance)
+            end = (end + 1) & mask;
+
+        // Shift the rest of the run up, starting from the empty Bucket at its end
+        for (; end != slot; end = (end - 1) & mask)
+        {
+            bucketType &source = buckets[(end - 1) & mask];
+            uint32_t moved = source.distance + 1;
+
+            relocate(buckets[end], source);
+            buckets[end].distance = moved;
+        }
+
+        buckets[slot].hash = hash;
+        buckets[slot].distance = distance;
+        return &buckets[slot];
+    }
+
+    /**
+     *  @brief Empties a Bucket, pulling every displaced successor one Bucket closer to home.
+     *  @param buckets The Bucket array.
+     *  @param capacity The number of Buckets in the array. Must be a power of two.
+     *  @param bucket The Bucket to empty. Anything it holds must have been released already.
+     *  @param relocate Moves a successor into the empty Bucket before it.
+     */
+    template <typename bucketType, typename relocatorType = CopyBucket>
+    static void erase(bucketType *buckets, const size_t &capacity, bucketType *bucket,
+                      relocatorType relocate = relocatorType())
+    {
+        size_t mask = capacity - 1;
+        size_t index = bucket - buckets;
+        size_t next = (index + 1) & mask;
+
+        while (buckets[next].distance > 1)
+        {
+            uint32_t moved = buckets[next].distance - 1;
+
+            relocate(buckets[index], buckets[next]);
+            buckets[index].distance = moved;
+
+            index = next;
+            next = (next + 1) & mask;
+        }
+
+        buckets[index].distance = 0;
+    }
+};
+#endif // _INCLUDE_ROBINHOOD_H_
@@ -0,0 +1,286 @@
+/**
+ *  @file StaticHashTable.h
+ *  @brief Declaration for a read only HashTable built at compile time around a minimal perfect hash.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_STATICHASHTABLE_H_
+#define _INCLUDE_STATICHASHTABLE_H_
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string_view>
+
+#include "Hashers.h"
+
+using namespace std;
+
+/**
+ *  @brief A key and value pair to build a StaticHashTable from.
+ *  @param valueType The type of the value.
+ */
+template <typename valueType>
+struct StaticEntry
+{
+    //! The key.
+    string_view key;
+    //! The value stored for key.
+    valueType value;
+};
+
+/**
+ *  @brief A read only table mapping a fixed set of string keys to values of valueType, laid out
+ *  by a minimal perfect hash that is found while compiling.
+ *  @param valueType The type of the values. It must be a literal type, such as string_view or an
+ *  integer, to build the StaticHashTable in a constant expression.
+ *  @param count The number of keys.
+ *  @detail The construction follows CHD (compress, hash and displace): every key is hashed once,
+ *  the hash is mixed so that all of its bits depend on the whole key, and the key is sent to one
+ *  of count groups by the high half. Groups are placed largest first, each searching for the
+ *  smallest seed that scatters all of its keys into distinct free slots. A seed picks both a
+ *  mix of the hash and a rotation of the slots, so any free slot is in reach even once the table
+ *  is nearly full. Should a group still find no seed, the whole search starts over with another
+ *  salt for the mix. Lookups hash the key, read the seed of its group and land on the only slot
+ *  the key could be in, so every lookup costs one hash, one seed load and one key comparison,
+ *  hit or miss. With as many slots as keys there is no wasted space.
+ *
+ *  Declared constexpr, the whole table including the seed search is evaluated by the compiler
+ *  and ends up as read only data, so there is nothing left to do at startup. Duplicate keys are
+ *  found before the search and turn into a compile error.
+ */
+template <typename valueType, size_t count>
+class StaticHashTable
+{
+    static_assert(count > 0, "A StaticHashTable needs at least one key");
+
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting the entries to hold.
+         *  @param entries The keys and values. Every key must be distinct.
+         *  @throw logic_error Thrown when two keys are equal, or share a 64 bit hash, since no seed
+         *  can separate them, or when no salt led to a seed for every group. In a constant
+         *  expression this is a compile error instead.
+         */
+        constexpr StaticHashTable(const StaticEntry<valueType> (&entries)[count])
+        {
+            static_assert(count <= UINT32_MAX / MAX_PATTERNS, "Too many keys for the seeds of a StaticHashTable");
+
+            while (!placeKeys(entries))
+                if (++mSalt == MAX_SALT)
+                    throw logic_error("StaticHashTable: no seeds found");
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        constexpr const valueType *find(string_view key) const
+        {
+            uint64_t hash = hashKey(key);
+            size_t slot = slotOf(hash, mSeeds[groupOf(hash)]);
+
+            return mKeys[slot] == key ? &mValues[slot] : NULL;
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this StaticHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        constexpr bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this StaticHashTable, in slot order.
+         *  @param functor A callable accepting a string_view and a const valueType &.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t slot = 0; slot < count; slot++)
+                functor(mKeys[slot], mValues[slot]);
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this StaticHashTable.
+         *  @return The number of keys.
+         */
+        constexpr size_t getSize(void) const
+        {
+            return count;
+        }
+
+    // Private Members
+    private:
+        //! Each group tries this many mixes of the hash, each at every rotation, before the salt is changed.
+        static constexpr uint32_t MAX_PATTERNS = 64;
+        //! Salts past this are not tried. Distinct keys almost never need more than the first.
+        static constexpr uint64_t MAX_SALT = 16;
+        //! Spreads the salts and seeds over the mix.
+        static constexpr uint64_t GOLDEN_RATIO = 0x9E3779B97F4A7C15ULL;
+
+        //! The key in each slot.
+        string_view mKeys[count] = { };
+        //! The value in each slot.
+        valueType mValues[count] = { };
+        //! The seed that places the keys of each group.
+        uint32_t mSeeds[count] = { };
+        //! Mixed into every hash, changed whenever a search fails.
+        uint64_t mSalt = 0;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Sorts the keys into groups and searches a seed for every group, with the
+         *  current salt.
+         *  @param entries The keys and values.
+         *  @return A boolean representing whether or not every group found a seed.
+         *  @throw logic_error Thrown when two keys are equal, or share a 64 bit hash.
+         */
+        constexpr bool placeKeys(const StaticEntry<valueType> (&entries)[count])
+        {
+            uint64_t hashes[count] = { };
+            size_t groupSizes[count] = { };
+            size_t groupStarts[count + 1] = { };
+            size_t groupMembers[count] = { };
+            bool occupied[count] = { };
+            size_t slots[count] = { };
+            size_t largestGroup = 0;
+
+            for (size_t index = 0; index < count; index++)
+            {
+                hashes[index] = hashKey(entries[index].key);
+                ++groupSizes[groupOf(hashes[index])];
+            }
+
+            // Lay the members of every group out next to each other
+            for (size_t group = 0; group < count; group++)
+            {
+                groupStarts[group + 1] = groupStarts[group] + groupSizes[group];
+                if (groupSizes[group] > largestGroup)
+                    largestGroup = groupSizes[group];
+            }
+
+            for (size_t index = 0; index < count; index++)
+            {
+                size_t group = groupOf(hashes[index]);
+                groupMembers[groupStarts[group] + --groupSizes[group]] = index;
+            }
+
+            // Keys with equal hashes always share a group, and no seed would ever separate them
+            for (size_t group = 0; group < count; group++)
+                for (size_t member = groupStarts[group]; member < groupStarts[group + 1]; member++)
+                    for (size_t other = groupStarts[group]; other < member; other++)
+                    {
+                        if (entries[groupMembers[member]].key == entries[groupMembers[other]].key)
+                            throw logic_error("StaticHashTable: duplicate key");
+                        if (hashes[groupMembers[member]] == hashes[groupMembers[other]])
+                            throw logic_error("StaticHashTable: keys share a hash");
+                    }
+
+            // Large groups are the hardest to fit, so they go first while the table is still empty
+            for (size_t size = largestGroup; size > 0; size--)
+                for (size_t group = 0; group < count; group++)
+                {
+                    if (groupStarts[group + 1] - groupStarts[group] != size)
+                        continue;
+
+                    for (uint32_t seed = 0; ; seed++)
+                    {
+                        if (seed == MAX_PATTERNS * count)
+                            return false;
+
+                        bool placed = true;
+                        for (size_t member = 0; member < size && placed; member++)
+                        {
+                            slots[member] = slotOf(hashes[groupMembers[groupStarts[group] + member]], seed);
+                            placed = !occupied[slots[member]];
+
+                            for (size_t other = 0; other < member && placed; other++)
+                                placed = slots[other] != slots[member];
+                        }
+
+                        if (!placed)
+                            continue;
+
+                        for (size_t member = 0; member < size; member++)
+                        {
+                            const StaticEntry<valueType> &entry = entries[groupMembers[groupStarts[group] + member]];
+
+                            occupied[slots[member]] = true;
+                            mKeys[slots[member]] = entry.key;
+                            mValues[slots[member]] = entry.value;
+                        }
+
+                        mSeeds[group] = seed;
+                        break;
+                    }
+                }
+
+            return true;
+        }
+
+        /**
+         *  @brief Hashes a key and mixes in the salt.
+         *  @param key The key to hash.
+         *  @return The mixed hash, whose every bit depends on the whole key.
+         */
+        constexpr uint64_t hashKey(string_view key) const
+        {
+            // FNV-1a leaves similar keys with similar high bits, which would crowd a few groups
+            return mix(FNV1aHasher::hash(key.data(), key.size()) + mSalt * GOLDEN_RATIO);
+        }
+
+        /**
+         *  @brief Returns the group a key belongs to.
+         *  @param hash The mixed hash of the key.
+         *  @return The index of the group.
+         */
+        static constexpr size_t groupOf(const uint64_t &hash)
+        {
+            return static_cast<size_t>((hash >> 32) % count);
+        }
+
+        /**
+         *  @brief Returns the slot a key lands on for a seed.
+         *  @param hash The mixed hash of the key.
+         *  @param seed The seed of the key's group. The quotient by count picks a mix of the hash
+         *  and the remainder rotates the slots.
+         *  @return The index of the slot.
+         */
+        static constexpr size_t slotOf(const uint64_t &hash, const uint32_t &seed)
+        {
+            size_t slot = static_cast<size_t>(mix(hash + (seed / count + 1) * GOLDEN_RATIO) % count);
+            return (slot + seed % count) % count;
+        }
+
+        /**
+         *  @brief Mixes a number so that every bit of the result depends on every bit of the input.
+         *  @param value The number to mix.
+         *  @return The mixed number.
+         */
+        static constexpr uint64_t mix(uint64_t value)
+        {
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+            return value ^ (value >> 31);
+        }
+};
+
+/**
+ *  @brief Builds a StaticHashTable, deducing the number of keys from the entries.
+ *  @param entries The keys and values. Every key must be distinct.
+ *  @return The StaticHashTable.
+ *  @throw logic_error Thrown when two keys are equal, or share a 64 bit hash, or no seeds were
+ *  found. In a constant expression this is a compile error instead.
+ */
+template <typename valueType, size_t count>
+constexpr StaticHashTable<valueType, count> makeStaticHashTable(const StaticEntry<valueType> (&entries)[count])
+{
+    return StaticHashTable<valueType, count>(entries);
+}
+#endif // _INCLUDE_STATICHASHTABLE_H_
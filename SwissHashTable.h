@@ -0,0 +1,597 @@
+/**
+ *  @file SwissHashTable.h
+ *  @brief Declaration for a generically typed, string keyed HashTable that probes sixteen
+ *  Buckets at a time.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_SWISSHASHTABLE_H_
+#define _INCLUDE_SWISSHASHTABLE_H_
+
+#include <new>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <string_view>
+#include <cstring>
+#include <utility>
+#include <stdint.h>
+#include <iostream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Hashers.h"
+
+using namespace std;
+
+/**
+ *  @brief A generically typed HashTable mapping string keys to pointers of storedType, laid
+ *  out in the style of a Swiss table.
+ *  @param storedType The type of the values to point to in our SwissHashTable.
+ *  @param hasherType The hash function, a type with a static hash() accepting the characters and
+ *  length of a key and returning 64 bits. See Hashers.h.
+ *  @detail Next to the slot array the SwissHashTable keeps one control byte per slot holding
+ *  either a 7 bit tag taken from the key's hash, CONTROL_EMPTY or CONTROL_DELETED. Slots are
+ *  grouped sixteen at a time; a probe loads the sixteen control bytes of a group, compares them
+ *  all against the tag with one SSE2 compare and turns the result into a bitmask of candidate
+ *  slots with movemask. Only candidates have their keys compared, and a group containing an
+ *  empty slot ends the probe. Groups are visited in triangular order, which reaches every group
+ *  of a power of two table. Without SSE2 the group is matched one byte at a time.
+ *  @note The SwissHashTable exposes the same interface as HashTable and does not own the
+ *  values it points to either.
+ */
+template <typename storedType, typename hasherType = FNV1aHasher>
+class SwissHashTable
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Constructor accepting an initial capacity.
+         *  @param initialCapacity The number of slots to start with. It is rounded up to a
+         *  power of two of at least one group.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the slot arrays.
+         */
+        SwissHashTable(const size_t &initialCapacity = 16) : mControl(NULL), mSlots(NULL), mSize(0), mDeleted(0)
+        {
+            size_t capacity = GROUP_WIDTH;
+            while (capacity < initialCapacity)
+                capacity <<= 1;
+
+            allocate(capacity);
+        }
+
+        /**
+         *  @brief Standard destructor.
+         */
+        ~SwissHashTable(void)
+        {
+            operator delete[](mControl, align_val_t(GROUP_WIDTH));
+            delete[] mSlots;
+        }
+
+        SwissHashTable(const SwissHashTable<storedType, hasherType> &) = delete;
+        SwissHashTable<storedType, hasherType>& operator =(const SwissHashTable<storedType, hasherType> &) = delete;
+
+        /**
+         *  @brief Associates value with key, replacing any value already stored for key.
+         *  @param key The key to store value under.
+         *  @param value A pointer to the value to store.
+         *  @return A boolean representing whether or not key was newly added.
+         *  @retval false Returned if key was already present and its value has been replaced.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap while growing the slot arrays.
+         */
+        bool add(string_view key, storedType *value)
+        {
+            uint64_t hash = hashKey(key.data(), key.size());
+            size_t index;
+
+            if (findIndex(key.data(), key.size(), hash, index))
+            {
+                mSlots[index].value = value;
+                return false;
+            }
+
+            if ((mSize + mDeleted + 1) * MAX_LOAD_DENOMINATOR > mCapacity * MAX_LOAD_NUMERATOR)
+                rehash(mSize * 2 * MAX_LOAD_DENOMINATOR > mCapacity * MAX_LOAD_NUMERATOR ? mCapacity << 1 : mCapacity);
+
+            index = findFreeIndex(hash);
+            if (mControl[index] == CONTROL_DELETED)
+                --mDeleted;
+
+            mControl[index] = tagOf(hash);
+            mSlots[index].key = key;
+            mSlots[index].value = value;
+
+            ++mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Looks up the value stored for key.
+         *  @param key The key to look up. A string, string_view or C string may be passed without
+         *  copying it into a temporary string.
+         *  @return A pointer to the value stored for key, or NULL if key is not present.
+         */
+        storedType *find(string_view key) const
+        {
+            size_t index;
+
+            if (!findIndex(key.data(), key.size(), hashKey(key.data(), key.size()), index))
+                return NULL;
+
+            return mSlots[index].value;
+        }
+
+        /**
+         *  @brief Returns whether or not key is present in this SwissHashTable.
+         *  @param key The key to look for.
+         *  @return A boolean representing whether or not key is present.
+         */
+        bool contains(string_view key) const
+        {
+            return this->find(key) != NULL;
+        }
+
+        /**
+         *  @brief Removes key and its value from this SwissHashTable.
+         *  @param key The key to remove.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if key was not present.
+         */
+        bool remove(string_view key)
+        {
+            size_t index;
+
+            if (!findIndex(key.data(), key.size(), hashKey(key.data(), key.size()), index))
+                return false;
+
+            // Probes stop at any group with an empty slot, so such a group never needs a tombstone
+            size_t group = index & ~(GROUP_WIDTH - 1);
+            if (matchEmpty(group))
+                mControl[index] = CONTROL_EMPTY;
+            else
+            {
+                mControl[index] = CONTROL_DELETED;
+                ++mDeleted;
+            }
+
+            mSlots[index].key.clear();
+            mSlots[index].value = NULL;
+
+            --mSize;
+            return true;
+        }
+
+        /**
+         *  @brief Calls functor with every key and value pair in this SwissHashTable.
+         *  @param functor A callable accepting a const string & and a storedType *.
+         *  @note The SwissHashTable must not be modified while this is running.
+         */
+        template <typename functorType>
+        void forEach(functorType functor) const
+        {
+            for (size_t index = 0; index < mCapacity; index++)
+                if (isFull(mControl[index]))
+                    functor(mSlots[index].key, mSlots[index].value);
+        }
+
+        /**
+         *  A summary of the state of a SwissHashTable, as returned by getStatistics().
+         */
+        struct Statistics
+        {
+            //! The number of keys stored.
+            size_t size;
+            //! The number of slots.
+            size_t capacity;
+            //! size divided by capacity.
+            double loadFactor;
+            //! For every probe length, the number of keys a lookup finds after loading that many
+            //! groups. Index 0 is unused; 1 means found in the home group.
+            vector<size_t> probeLengths;
+            //! The longest probe length of any key.
+            size_t maxProbeLength;
+            //! The average probe length of a lookup for a present key.
+            double meanProbeLength;
+            //! The slots holding CONTROL_DELETED. They count against the load limit and make
+            //! misses probe further until the next rehash drops them.
+            size_t deletedSlots;
+            //! The bytes taken by the slot array and the control bytes.
+            size_t slotBytes;
+            //! The heap bytes taken by keys too long to be stored inside their Slot.
+            size_t keyBytes;
+            //! The bytes of the values pointed to. The SwissHashTable does not own them, so they
+            //! are not part of totalBytes.
+            size_t valueBytes;
+            //! slotBytes plus keyBytes.
+            size_t totalBytes;
+
+            /**
+             *  @brief Formats the Statistics as a JSON object.
+             *  @return The JSON text, on one line.
+             */
+            string toJSON(void) const
+            {
+                ostringstream stream;
+
+                stream << "{\"size\":" << size << ",\"capacity\":" << capacity << ",\"loadFactor\":" << loadFactor
+                       << ",\"probeLengths\":[";
+
+                for (size_t length = 1; length < probeLengths.size(); length++)
+                    stream << (length > 1 ? "," : "") << probeLengths[length];
+
+                stream << "],\"maxProbeLength\":" << maxProbeLength << ",\"meanProbeLength\":" << meanProbeLength
+                       << ",\"deletedSlots\":" << deletedSlots << ",\"slotBytes\":" << slotBytes
+                       << ",\"keyBytes\":" << keyBytes << ",\"valueBytes\":" << valueBytes
+                       << ",\"totalBytes\":" << totalBytes << "}";
+
+                return stream.str();
+            }
+        };
+
+        /**
+         *  @brief Returns a summary of the state of this SwissHashTable.
+         *  @return The Statistics of this SwissHashTable.
+         *  @note This walks every slot and hashes every key again to find its home group.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the probe length histogram.
+         */
+        Statistics getStatistics(void) const
+        {
+            Statistics result;
+
+            result.size = mSize;
+            result.capacity = mCapacity;
+            result.loadFactor = static_cast<double>(mSize) / mCapacity;
+            result.maxProbeLength = 0;
+            result.deletedSlots = 0;
+            result.keyBytes = 0;
+
+            size_t groupMask = mCapacity / GROUP_WIDTH - 1;
+            size_t probeTotal = 0;
+
+            for (size_t index = 0; index < mCapacity; index++)
+            {
+                if (mControl[index] == CONTROL_DELETED)
+                    ++result.deletedSlots;
+
+                if (!isFull(mControl[index]))
+                    continue;
+
+                // Follow the probe sequence from the home group until it reaches the slot's group
+                const string &key = mSlots[index].key;
+                size_t group = (hashKey(key.data(), key.size()) >> 7) & groupMask;
+                size_t length = 1;
+
+                for (; group != index / GROUP_WIDTH && length <= groupMask; length++)
+                    group = (group + length) & groupMask;
+
+                if (result.probeLengths.size() <= length)
+                    result.probeLengths.resize(length + 1);
+
+                ++result.probeLengths[length];
+                probeTotal += length;
+                if (length > result.maxProbeLength)
+                    result.maxProbeLength = length;
+
+                // Short keys live inside the string object itself, in the Slot
+                uintptr_t data = reinterpret_cast<uintptr_t>(key.data());
+                uintptr_t storage = reinterpret_cast<uintptr_t>(&key);
+                if (data < storage || data >= storage + sizeof(string))
+                    result.keyBytes += key.capacity() + 1;
+            }
+
+            result.meanProbeLength = mSize ? static_cast<double>(probeTotal) / mSize : 0.0;
+            result.slotBytes = mCapacity * (sizeof(Slot) + sizeof(int8_t));
+            result.valueBytes = mSize * sizeof(storedType);
+            result.totalBytes = result.slotBytes + result.keyBytes;
+
+            return result;
+        }
+
+        /**
+         *  @brief Returns the number of keys stored in this SwissHashTable.
+         *  @return The number of keys currently stored.
+         */
+        size_t getSize(void) const
+        {
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns the number of slots in this SwissHashTable.
+         *  @return The current capacity.
+         */
+        size_t getCapacity(void) const
+        {
+            return mCapacity;
+        }
+
+        /**
+         *  @brief Returns whether or not this SwissHashTable is empty.
+         *  @return A boolean representing whether or not this SwissHashTable is empty.
+         */
+        bool isEmpty(void) const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         *  @brief Stream insertion operator to put a SwissHashTable into a stream. Every value
+         *  is written on its own line, in slot order.
+         *  @param stream The std::ostream to write into.
+         *  @param input The SwissHashTable to write into the stream.
+         *  @return A reference to the input stream.
+         */
+        friend ostream& operator <<(ostream &stream, const SwissHashTable<storedType, hasherType> &input)
+        {
+            bool first = true;
+
+            for (size_t index = 0; index < input.mCapacity; index++)
+            {
+                if (!isFull(input.mControl[index]))
+                    continue;
+
+                if (!first)
+                    stream << "\n";
+
+                stream << *input.mSlots[index].value;
+                first = false;
+            }
+
+            return stream;
+        }
+
+    // Private Members
+    private:
+        /**
+         *  A key and value pair. Whether it is in use is recorded in the control bytes.
+         */
+        struct Slot
+        {
+            //! Constructs an unused Slot.
+            Slot(void) : value(NULL)
+            {
+
+            }
+
+            //! The key stored in this Slot.
+            string key;
+            //! A pointer to the value stored for key.
+            storedType *value;
+        };
+
+        //! The number of slots probed at once.
+        static constexpr size_t GROUP_WIDTH = 16;
+        //! The control byte of a slot that has never been used since the last rehash.
+        static constexpr int8_t CONTROL_EMPTY = -128;
+        //! The control byte of a slot whose entry was removed.
+        static constexpr int8_t CONTROL_DELETED = -2;
+        //! The SwissHashTable rehashes once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+        //! The SwissHashTable rehashes once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of it is in use.
+        static constexpr size_t MAX_LOAD_DENOMINATOR = 8;
+
+        //! One control byte per slot.
+        int8_t *mControl;
+        //! The slot array.
+        Slot *mSlots;
+        //! The number of slots. Always a power of two and a multiple of GROUP_WIDTH.
+        size_t mCapacity;
+        //! The number of keys stored.
+        size_t mSize;
+        //! The number of slots holding CONTROL_DELETED.
+        size_t mDeleted;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Hashes a key with hasherType.
+         *  @param key A pointer to the characters of the key.
+         *  @param length The number of characters in the key.
+         *  @return The hash of the key.
+         */
+        static uint64_t hashKey(const char *key, const size_t &length)
+        {
+            uint64_t hash = hasherType::hash(key, length);
+            return hash ^ (hash >> 32);
+        }
+
+        /**
+         *  @brief Returns the 7 bit tag stored in the control byte for a hash.
+         *  @param hash The hash of a key.
+         *  @return The tag, which is always a non-negative control byte.
+         */
+        static int8_t tagOf(const uint64_t &hash)
+        {
+            return static_cast<int8_t>(hash & 0x7F);
+        }
+
+        /**
+         *  @brief Returns whether or not a control byte marks a slot in use.
+         *  @param control The control byte.
+         *  @return A boolean representing whether or not the slot holds an entry.
+         */
+        static bool isFull(const int8_t &control)
+        {
+            return control >= 0;
+        }
+
+        /**
+         *  @brief Returns a bitmask of the slots of a group whose control byte equals value.
+         *  @param group The index of the first slot of the group.
+         *  @param value The control byte to look for.
+         *  @return A bitmask with bit n set when slot group + n matches.
+         */
+        uint32_t match(const size_t &group, int8_t value) const
+        {
+#ifdef __SSE2__
+            __m128i control = _mm_load_si128(reinterpret_cast<const __m128i *>(mControl + group));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+            uint32_t result = 0;
+            for (size_t offset = 0; offset < GROUP_WIDTH; offset++)
+                if (mControl[group + offset] == value)
+                    result |= 1U << offset;
+
+            return result;
+#endif
+        }
+
+        /**
+         *  @brief Returns a bitmask of the empty slots of a group.
+         *  @param group The index of the first slot of the group.
+         *  @return A bitmask with bit n set when slot group + n is empty.
+         */
+        uint32_t matchEmpty(const size_t &group) const
+        {
+            return match(group, CONTROL_EMPTY);
+        }
+
+        /**
+         *  @brief Returns a bitmask of the empty or deleted slots of a group.
+         *  @param group The index of the first slot of the group.
+         *  @return A bitmask with bit n set when slot group + n can take a new entry.
+         */
+        uint32_t matchFree(const size_t &group) const
+        {
+#ifdef __SSE2__
+            // Both free markers are negative while tags are not, so the sign bits are the answer
+            __m128i control = _mm_load_si128(reinterpret_cast<const __m128i *>(mControl + group));
+            return static_cast<uint32_t>(_mm_movemask_epi8(control));
+#else
+            uint32_t result = 0;
+            for (size_t offset = 0; offset < GROUP_WIDTH; offset++)
+                if (!isFull(mControl[group + offset]))
+                    result |= 1U << offset;
+
+            return result;
+#endif
+        }
+
+        /**
+         *  @brief Finds the slot holding a key.
+         *  @param key A pointer to the characters of the key.
+         *  @param length The number of characters in the key.
+         *  @param hash The hash of the key.
+         *  @param index Assigned the index of the slot holding the key, if it was found.
+         *  @return A boolean representing whether or not the key was found.
+         */
+        bool findIndex(const char *key, const size_t &length, const uint64_t &hash, size_t &index) const
+        {
+            size_t groupMask = mCapacity / GROUP_WIDTH - 1;
+            size_t group = (hash >> 7) & groupMask;
+            int8_t tag = tagOf(hash);
+
+            for (size_t step = 1; ; step++)
+            {
+                size_t base = group * GROUP_WIDTH;
+
+                for (uint32_t candidates = match(base, tag); candidates; candidates &= candidates - 1)
+                {
+                    size_t current = base + __builtin_ctz(candidates);
+                    const Slot &slot = mSlots[current];
+
+                    if (slot.key.size() == length && !slot.key.compare(0, length, key, length))
+                    {
+                        index = current;
+                        return true;
+                    }
+                }
+
+                if (matchEmpty(base))
+                    return false;
+
+                group = (group + step) & groupMask;
+            }
+        }
+
+        /**
+         *  @brief Finds the first empty or deleted slot along the probe sequence of a hash.
+         *  @param hash The hash of the key to place.
+         *  @return The index of the slot.
+         *  @note The load limit guarantees such a slot exists.
+         */
+        size_t findFreeIndex(const uint64_t &hash) const
+        {
+            size_t groupMask = mCapacity / GROUP_WIDTH - 1;
+            size_t group = (hash >> 7) & groupMask;
+
+            for (size_t step = 1; ; step++)
+            {
+                size_t base = group * GROUP_WIDTH;
+                uint32_t candidates = matchFree(base);
+
+                if (candidates)
+                    return base + __builtin_ctz(candidates);
+
+                group = (group + step) & groupMask;
+            }
+        }
+
+        /**
+         *  @brief Allocates empty slot arrays of the given capacity.
+         *  @param capacity The new capacity. Must be a power of two of at least GROUP_WIDTH.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the slot arrays.
+         */
+        void allocate(const size_t &capacity)
+        {
+            Slot *slots = new Slot[capacity];
+            int8_t *control;
+
+            try
+            {
+                // Groups are loaded with aligned loads, and new[] only guarantees the alignment of int8_t
+                control = new (align_val_t(GROUP_WIDTH)) int8_t[capacity];
+            }
+            catch (bad_alloc &e)
+            {
+                delete[] slots;
+                throw;
+            }
+
+            memset(control, CONTROL_EMPTY, capacity);
+
+            mControl = control;
+            mSlots = slots;
+            mCapacity = capacity;
+        }
+
+        /**
+         *  @brief Moves every entry into fresh slot arrays, dropping all tombstones.
+         *  @param capacity The new capacity. Must be a power of two of at least GROUP_WIDTH.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the new slot arrays.
+         */
+        void rehash(const size_t &capacity)
+        {
+            int8_t *oldControl = mControl;
+            Slot *oldSlots = mSlots;
+            size_t oldCapacity = mCapacity;
+
+            allocate(capacity);
+            mDeleted = 0;
+
+            for (size_t index = 0; index < oldCapacity; index++)
+            {
+                if (!isFull(oldControl[index]))
+                    continue;
+
+                uint64_t hash = hashKey(oldSlots[index].key.data(), oldSlots[index].key.size());
+                size_t target = findFreeIndex(hash);
+
+                mControl[target] = tagOf(hash);
+                mSlots[target].key = std::move(oldSlots[index].key);
+                mSlots[target].value = oldSlots[index].value;
+            }
+
+            operator delete[](oldControl, align_val_t(GROUP_WIDTH));
+            delete[] oldSlots;
+        }
+};
+#endif // _INCLUDE_SWISSHASHTABLE_H_
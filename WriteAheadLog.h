@@ -0,0 +1,562 @@
+/**
+ *  @file WriteAheadLog.h
+ *  @brief Declaration for an append only log of key and value pairs, made durable in batches.
+ *  @author Robert MacGregor
+ */
+
+#ifndef _INCLUDE_WRITEAHEADLOG_H_
+#define _INCLUDE_WRITEAHEADLOG_H_
+
+#include <mutex>
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <stdint.h>
+#include <stdexcept>
+#include <string_view>
+#include <condition_variable>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+/**
+ *  @brief The layout of a WriteAheadLog file.
+ *  @detail A file starts with a Header, followed by Records one after another. Each Record is a
+ *  RecordHeader followed by the key and the value characters. The checksum covers both lengths
+ *  and the characters, so a Record cut short by a crash, or garbage past the last Record, is
+ *  recognized and dropped instead of being read back as a pair. Numbers are stored in native byte
+ *  order; the Header records which, and files from a machine of the other order are refused.
+ */
+struct WriteAheadLogFormat
+{
+    /**
+     *  The start of a file.
+     */
+    struct Header
+    {
+        //! Always MAGIC.
+        char magic[8];
+        //! Always VERSION.
+        uint32_t version;
+        //! BYTE_ORDER_MARK as written by the machine that wrote the file.
+        uint32_t byteOrder;
+    };
+
+    /**
+     *  The start of a Record.
+     */
+    struct RecordHeader
+    {
+        //! The CRC-32 of keyLength, valueLength, the key and the value.
+        uint32_t checksum;
+        //! The number of characters in the key.
+        uint32_t keyLength;
+        //! The number of characters in the value.
+        uint32_t valueLength;
+    };
+
+    //! Identifies a WriteAheadLog file.
+    static constexpr char MAGIC[8] = { 'H', 'T', 'W', 'A', 'L', 'O', 'G', '1' };
+    //! The version of the layout described here.
+    static constexpr uint32_t VERSION = 1;
+    //! Reads back differently on a machine of the other byte order.
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304U;
+
+    /**
+     *  @brief Continues a CRC-32 (the IEEE polynomial, as in zlib) over more bytes.
+     *  @param data A pointer to the bytes.
+     *  @param length The number of bytes.
+     *  @param seed The CRC-32 of the bytes before these, or 0 to start.
+     *  @return The CRC-32 of all the bytes so far.
+     */
+    static uint32_t checksum(const void *data, const size_t &length, const uint32_t &seed = 0)
+    {
+        /**
+         *  The CRC-32 of every byte value, so each byte costs one lookup.
+         */
+        struct Table
+        {
+            //! The entries, indexed by byte value.
+            uint32_t entries[256];
+
+            Table(void)
+            {
+                for (uint32_t value = 0; value < 256; value++)
+                {
+                    uint32_t entry = value;
+                    for (unsigned int bit = 0; bit < 8; bit++)
+                        entry = (entry >> 1) ^ (entry & 1 ? 0xEDB88320U : 0);
+
+                    entries[value] = entry;
+                }
+            }
+        };
+
+        static const Table table;
+
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        uint32_t result = ~seed;
+
+        for (size_t index = 0; index < length; index++)
+            result = table.entries[(result ^ bytes[index]) & 0xFF] ^ (result >> 8);
+
+        return ~result;
+    }
+
+    /**
+     *  @brief Returns the checksum a Record with the given key and value carries.
+     *  @param record The RecordHeader, whose lengths are covered.
+     *  @param key The key characters.
+     *  @param value The value characters.
+     *  @return The checksum.
+     */
+    static uint32_t checksum(const RecordHeader &record, const char *key, const char *value)
+    {
+        uint32_t result = checksum(&record.keyLength, sizeof(record.keyLength));
+        result = checksum(&record.valueLength, sizeof(record.valueLength), result);
+        result = checksum(key, record.keyLength, result);
+        return checksum(value, record.valueLength, result);
+    }
+};
+
+/**
+ *  @brief An append only log of key and value pairs in a file, for making changes to a table
+ *  durable before they are applied.
+ *  @detail append() only copies a Record into a buffer in memory. commit() makes every Record up
+ *  to a sequence number durable. The first thread to commit writes the whole buffer and
+ *  syncs it to the disk. Threads that commit while that sync is running wait for it, and
+ *  the next of them writes everything buffered meanwhile with a single further sync, so
+ *  concurrent commits share syncs instead of queueing for one each.
+ *
+ *  open() reads back every Record already in the file. The file is cut at the first Record
+ *  that is incomplete or fails its checksum, which is where an earlier process stopped writing.
+ *  reset() drops the Records up to a sequence number once they have been saved elsewhere, as a
+ *  checkpoint does, and keeps the ones appended after them.
+ *  @note append(), commit(), reset() and the getters may be called from any number of threads at
+ *  once; open() and close() must not overlap with anything else.
+ */
+class WriteAheadLog
+{
+    // Public Methods
+    public:
+        /**
+         *  @brief Parameter-less constructor. The WriteAheadLog is closed until open() is called.
+         */
+        WriteAheadLog(void) : mDescriptor(-1), mSize(0), mAppended(0), mDurable(0), mSyncCount(0),
+        mFlushing(false), mFailed(false)
+        {
+
+        }
+
+        /**
+         *  @brief Standard destructor. Commits any Records still buffered.
+         */
+        ~WriteAheadLog(void)
+        {
+            close();
+        }
+
+        WriteAheadLog(const WriteAheadLog &) = delete;
+        WriteAheadLog& operator =(const WriteAheadLog &) = delete;
+
+        /**
+         *  @brief Opens a log file, creating it if it does not exist, and reads back the pairs
+         *  already in it. Any log opened before is closed first.
+         *  @param path The path of the file.
+         *  @param functor A callable accepting the key and the value of each pair as string_views,
+         *  in the order they were appended. They are only valid during the call.
+         *  @return A boolean representing whether or not the operation was successful.
+         *  @retval false Returned if the file could not be opened or created, or is not a
+         *  WriteAheadLog file, in which case it is left untouched.
+         *  @throw Anything thrown by functor is passed on, and the log is left closed.
+         */
+        template <typename functorType>
+        bool open(const string &path, functorType functor)
+        {
+            typedef WriteAheadLogFormat Format;
+
+            close();
+
+            int descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+            if (descriptor < 0)
+                return false;
+
+            struct stat status;
+            if (fstat(descriptor, &status))
+            {
+                ::close(descriptor);
+                return false;
+            }
+
+            uint64_t size = status.st_size;
+            uint64_t valid = 0;
+
+            // A file too short for its Header was cut off while being created, and holds nothing
+            if (size >= sizeof(Format::Header))
+            {
+                void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    ::close(descriptor);
+                    return false;
+                }
+
+                const char *data = static_cast<const char *>(mapping);
+                const Format::Header *header = static_cast<const Format::Header *>(mapping);
+
+                if (memcmp(header->magic, Format::MAGIC, sizeof(header->magic)) ||
+                    header->version != Format::VERSION || header->byteOrder != Format::BYTE_ORDER_MARK)
+                {
+                    munmap(mapping, size);
+                    ::close(descriptor);
+                    return false;
+                }
+
+                try
+                {
+                    valid = replay(data, size, functor);
+                }
+                catch (...)
+                {
+                    munmap(mapping, size);
+                    ::close(descriptor);
+                    throw;
+                }
+
+                munmap(mapping, size);
+            }
+
+            bool prepared = true;
+            if (!valid)
+            {
+                Format::Header header;
+                memcpy(header.magic, Format::MAGIC, sizeof(header.magic));
+                header.version = Format::VERSION;
+                header.byteOrder = Format::BYTE_ORDER_MARK;
+
+                prepared = !ftruncate(descriptor, 0) && writeAll(descriptor, &header, sizeof(header)) &&
+                           !fsync(descriptor) && syncDirectory(path);
+                valid = sizeof(header);
+            }
+            else if (valid < size)
+                prepared = !ftruncate(descriptor, valid) && !fsync(descriptor);
+
+            if (!prepared)
+            {
+                ::close(descriptor);
+                return false;
+            }
+
+            lock_guard<mutex> guard(mLock);
+            mDescriptor = descriptor;
+            mSize = valid;
+            mFailed = false;
+            return true;
+        }
+
+        /**
+         *  @brief Commits any Records still buffered and closes the file.
+         */
+        void close(void)
+        {
+            unique_lock<mutex> guard(mLock);
+            uint64_t appended = mAppended;
+            guard.unlock();
+
+            commit(appended);
+
+            guard.lock();
+            if (mDescriptor >= 0)
+                ::close(mDescriptor);
+
+            // Should the commit have failed, the Records it dropped stay short of mDurable
+            mDescriptor = -1;
+            mSize = 0;
+            mPending.clear();
+        }
+
+        /**
+         *  @brief Buffers a Record of a key and value pair. It is not durable until committed.
+         *  @param key The key.
+         *  @param value The value.
+         *  @param sequence Assigned the sequence number of the Record, to pass to commit().
+         *  @return A boolean representing whether or not the Record was buffered.
+         *  @retval false Returned if the log is not open, or writing it has failed.
+         *  @throw length_error Thrown when key or value is longer than a Record can hold.
+         *  @throw bad_alloc Thrown when there was a failure to allocate memory in
+         *  the heap for the buffer.
+         */
+        bool append(string_view key, string_view value, uint64_t &sequence)
+        {
+            typedef WriteAheadLogFormat Format;
+
+            if (key.size() > UINT32_MAX || value.size() > UINT32_MAX)
+                throw length_error("WriteAheadLog Records hold at most 4 GiB keys and values.");
+
+            Format::RecordHeader record;
+            record.keyLength = static_cast<uint32_t>(key.size());
+            record.valueLength = static_cast<uint32_t>(value.size());
+            record.checksum = Format::checksum(record, key.data(), value.data());
+
+            lock_guard<mutex> guard(mLock);
+            if (mDescriptor < 0 || mFailed)
+                return false;
+
+            size_t length = mPending.size();
+            mPending.reserve(length + sizeof(record) + key.size() + value.size());
+            mPending.append(reinterpret_cast<const char *>(&record), sizeof(record));
+            mPending.append(key);
+            mPending.append(value);
+
+            mSize += mPending.size() - length;
+            sequence = ++mAppended;
+            return true;
+        }
+
+        /**
+         *  @brief Waits until every Record up to sequence is durable, writing and syncing the
+         *  buffer if no other thread already is.
+         *  @param sequence The sequence number of the last Record that must be durable.
+         *  @return A boolean representing whether or not those Records are durable.
+         *  @retval false Returned if writing or syncing the file has failed. The log stays failed
+         *  until it is opened again, which drops whatever part of a Record made it to the file.
+         */
+        bool commit(const uint64_t &sequence)
+        {
+            unique_lock<mutex> guard(mLock);
+
+            while (mDurable < sequence && !mFailed && mDescriptor >= 0)
+            {
+                if (mFlushing)
+                {
+                    mFlushed.wait(guard);
+                    continue;
+                }
+
+                // This thread leads the next group; appends made meanwhile go into mPending
+                mFlushing = true;
+                mWriting.swap(mPending);
+                uint64_t last = mAppended;
+
+                guard.unlock();
+                bool written = writeAll(mDescriptor, mWriting.data(), mWriting.size()) && !fdatasync(mDescriptor);
+                mWriting.clear();
+                guard.lock();
+
+                mFlushing = false;
+                if (written)
+                {
+                    mDurable = last;
+                    ++mSyncCount;
+                }
+                else
+                    mFailed = true;
+
+                mFlushed.notify_all();
+            }
+
+            return mDurable >= sequence;
+        }
+
+        /**
+         *  @brief Drops the Records up to a sequence number, written or still buffered, once they
+         *  have been saved elsewhere. Records appended after them stay buffered for commit().
+         *  @param upTo The sequence number of the last Record that has been saved elsewhere.
+         *  @return A boolean representing whether or not those Records were dropped.
+         *  @retval false Returned if the log is not open, the file could not be cut, a Record
+         *  after upTo has already been written to the file, or writing has failed and upTo does
+         *  not cover every Record. The log is left as it was.
+         *  @note Records up to upTo that were still buffered only become durable through whatever
+         *  saved them, so commit() for them waits for the next sync like any other.
+         */
+        bool reset(const uint64_t &upTo)
+        {
+            typedef WriteAheadLogFormat Format;
+
+            unique_lock<mutex> guard(mLock);
+
+            while (mFlushing)
+                mFlushed.wait(guard);
+
+            if (mDescriptor < 0)
+                return false;
+
+            // mPending holds the last Records appended, so the ones before them are in the file,
+            // or were lost by a failed write, in which case only covering all of them will do
+            uint64_t buffered = 0;
+            for (size_t offset = 0; offset < mPending.size(); buffered++)
+                offset += recordLength(mPending.data() + offset);
+
+            uint64_t covered = upTo < mAppended ? upTo : mAppended;
+            if (covered < mAppended - buffered || (mFailed && covered < mAppended))
+                return false;
+
+            size_t dropped = 0;
+            for (uint64_t sequence = mAppended - buffered; sequence < covered; sequence++)
+                dropped += recordLength(mPending.data() + dropped);
+
+            if (ftruncate(mDescriptor, sizeof(Format::Header)) || fsync(mDescriptor))
+                return false;
+
+            mPending.erase(0, dropped);
+
+            mSize = sizeof(Format::Header) + mPending.size();
+            mFailed = false;
+            return true;
+        }
+
+        /**
+         *  @brief Returns whether or not a log file is open.
+         *  @return A boolean representing whether or not open() has succeeded since the last close().
+         */
+        bool isOpen(void) const
+        {
+            lock_guard<mutex> guard(mLock);
+            return mDescriptor >= 0;
+        }
+
+        /**
+         *  @brief Returns the size of the log, counting Records still buffered.
+         *  @return The number of bytes.
+         */
+        uint64_t getSize(void) const
+        {
+            lock_guard<mutex> guard(mLock);
+            return mSize;
+        }
+
+        /**
+         *  @brief Returns the number of times commit() has synced the file, which is less than
+         *  the number of Records committed whenever commits were grouped.
+         *  @return The number of syncs.
+         */
+        uint64_t getSyncCount(void) const
+        {
+            lock_guard<mutex> guard(mLock);
+            return mSyncCount;
+        }
+
+        /**
+         *  @brief Syncs the directory holding a file, so that creating or renaming the file
+         *  survives a crash as well.
+         *  @param path The path of the file.
+         *  @return A boolean representing whether or not the operation was successful.
+         */
+        static bool syncDirectory(const string &path)
+        {
+            size_t slash = path.rfind('/');
+            string directory = slash == string::npos ? "." : slash ? path.substr(0, slash) : "/";
+
+            int descriptor = ::open(directory.c_str(), O_RDONLY);
+            if (descriptor < 0)
+                return false;
+
+            bool result = !fsync(descriptor);
+            ::close(descriptor);
+            return result;
+        }
+
+    // Private Members
+    private:
+        //! Guards everything below.
+        mutable mutex mLock;
+        //! Signalled whenever a group commit finishes.
+        condition_variable mFlushed;
+        //! The open log file, or -1.
+        int mDescriptor;
+        //! Records appended since the last group commit started.
+        string mPending;
+        //! Records being written by the current group commit. Only its leader touches this.
+        string mWriting;
+        //! The size of the file plus mPending and mWriting.
+        uint64_t mSize;
+        //! The sequence number of the last Record appended.
+        uint64_t mAppended;
+        //! The sequence number of the last Record known to be durable.
+        uint64_t mDurable;
+        //! The number of syncs made by commit().
+        uint64_t mSyncCount;
+        //! Whether or not a group commit is writing.
+        bool mFlushing;
+        //! Whether or not a write or sync has failed.
+        bool mFailed;
+
+    // Private Methods
+    private:
+        /**
+         *  @brief Reads back the Records of a mapped file.
+         *  @param data A pointer to the file, starting with a valid Header.
+         *  @param size The size of the file.
+         *  @param functor A callable accepting the key and value of each Record as string_views.
+         *  @return The offset just past the last intact Record.
+         */
+        template <typename functorType>
+        static uint64_t replay(const char *data, const uint64_t &size, functorType &functor)
+        {
+            typedef WriteAheadLogFormat Format;
+
+            uint64_t offset = sizeof(Format::Header);
+
+            while (size - offset >= sizeof(Format::RecordHeader))
+            {
+                Format::RecordHeader record;
+                memcpy(&record, data + offset, sizeof(record));
+
+                const char *key = data + offset + sizeof(record);
+                uint64_t length = static_cast<uint64_t>(record.keyLength) + record.valueLength;
+
+                if (length > size - offset - sizeof(record) ||
+                    Format::checksum(record, key, key + record.keyLength) != record.checksum)
+                    break;
+
+                functor(string_view(key, record.keyLength), string_view(key + record.keyLength, record.valueLength));
+                offset += sizeof(record) + length;
+            }
+
+            return offset;
+        }
+
+        /**
+         *  @brief Returns the length of a whole Record in a buffer.
+         *  @param data A pointer to the start of the Record.
+         *  @return The number of bytes of its RecordHeader, key and value.
+         */
+        static size_t recordLength(const char *data)
+        {
+            WriteAheadLogFormat::RecordHeader record;
+            memcpy(&record, data, sizeof(record));
+            return sizeof(record) + static_cast<size_t>(record.keyLength) + record.valueLength;
+        }
+
+        /**
+         *  @brief Writes all of a buffer to a file, however many calls that takes.
+         *  @param descriptor The file.
+         *  @param data A pointer to the bytes.
+         *  @param length The number of bytes.
+         *  @return A boolean representing whether or not every byte was written.
+         */
+        static bool writeAll(const int &descriptor, const void *data, size_t length)
+        {
+            const char *current = static_cast<const char *>(data);
+
+            while (length)
+            {
+                ssize_t written = write(descriptor, current, length);
+                if (written < 0 && errno == EINTR)
+                    continue;
+
+                if (written <= 0)
+                    return false;
+
+                current += written;
+                length -= written;
+            }
+
+            return true;
+        }
+};
+#endif // _INCLUDE_WRITEAHEADLOG_H_
@@ -0,0 +1,77 @@
+#include <iostream>
+
+#include "AsyncQueue.h"
+#include "Executor.h"
+
+using namespace std;
+
+//! The number of coroutines waiting on the AsyncQueue at once.
+#define CONSUMER_COUNT 10000
+
+/**
+ *  @brief A consumer coroutine that pops a single value and adds it to a running total.
+ *  @param queue The AsyncQueue to pop from.
+ *  @param total The running total to add the popped value to.
+ */
+Task consume(AsyncQueue<int> &queue, long long &total)
+{
+    int value = co_await queue.pop();
+    total += value;
+}
+
+/**
+ *  @brief A consumer coroutine that echoes everything it pops until it pops zero.
+ *  @param queue The AsyncQueue to pop from.
+ */
+Task echo(AsyncQueue<int> &queue)
+{
+    int value;
+    while ((value = co_await queue.pop()) != 0)
+        cout << "Popped " << value << endl;
+
+    cout << "Echo Done" << endl;
+}
+
+int main(void)
+{
+    Executor executor;
+    AsyncQueue<int> q1(executor);
+
+    // Values added before anyone waits are buffered
+    for (int i = 10; i < 50; i += 10)
+        q1.add(i);
+
+    cout << q1 << endl;
+
+    executor.spawn(echo(q1));
+    executor.run();
+
+    // The echo coroutine is now suspended on an empty queue
+    for (int i = 50; i < 100; i += 10)
+    {
+        q1.add(i);
+        executor.run();
+    }
+
+    q1.add(0);
+    executor.run();
+
+    // Park a large number of consumers, none of which owns a thread
+    AsyncQueue<int> q2(executor);
+    long long total = 0;
+
+    for (int i = 0; i < CONSUMER_COUNT; i++)
+        executor.spawn(consume(q2, total));
+
+    executor.run();
+    cout << CONSUMER_COUNT << " consumers waiting: " << (q2.hasWaiters() ? "yes" : "no") << endl;
+
+    for (int i = 1; i <= CONSUMER_COUNT; i++)
+        q2.add(i);
+
+    size_t resumed = executor.run();
+    cout << "Resumed " << resumed << " consumers, total " << total << endl;
+    cout << "Job Done" << endl;
+
+    return 0;
+}
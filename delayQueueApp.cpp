@@ -0,0 +1,140 @@
+/**
+ *  @file delayQueueApp.cpp
+ *  @brief Driver that checks the DelayQueue against a binary heap and compares their speed.
+ *  @author Robert MacGregor
+ */
+
+#include <queue>        // std::priority_queue
+#include <chrono>       // std::chrono::steady_clock
+#include <random>       // std::mt19937_64
+#include <vector>       // std::vector
+#include <cstdlib>      // atol
+#include <iostream>
+#include <algorithm>    // std::sort
+
+#include "DelayQueue.h"
+
+using namespace std;
+
+//! The default number of pending timers.
+#define DEFAULT_TIMER_COUNT 1000000
+//! Deadlines are spread uniformly over this many ticks.
+#define DEADLINE_SPAN 1000000
+//! The clock moves forward by this many ticks per advance.
+#define TICK_STEP 100
+
+//! A heap entry: a deadline and the id of the timer.
+typedef pair<uint64_t, size_t> HeapEntry;
+//! A min-heap of HeapEntry.
+typedef priority_queue<HeapEntry, vector<HeapEntry>, greater<HeapEntry> > TimerHeap;
+
+/**
+ *  @brief Returns the number of milliseconds elapsed since start.
+ *  @param start The time point to measure from.
+ *  @return The elapsed milliseconds.
+ */
+static double elapsedMilliseconds(const chrono::steady_clock::time_point &start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ *  @brief Main entry point of the program.
+ *  @param argc The number of arguments that can be
+ *  found in argv.
+ *  @param argv The space-delineated parameter list passed
+ *  in the operating system. The optional first argument is the timer count.
+ */
+int main(int argc, char *argv[])
+{
+    size_t timerCount = argc > 1 ? atol(argv[1]) : DEFAULT_TIMER_COUNT;
+
+    mt19937_64 generator(42);
+    vector<uint64_t> deadlines(timerCount);
+    for (size_t iteration = 0; iteration < timerCount; iteration++)
+        deadlines[iteration] = 1 + generator() % DEADLINE_SPAN;
+
+    // Every tenth timer is cancelled before it expires
+    vector<bool> cancelled(timerCount);
+    for (size_t iteration = 0; iteration < timerCount; iteration += 10)
+        cancelled[iteration] = true;
+
+    // Timing wheel
+    vector<size_t> wheelOrder;
+    wheelOrder.reserve(timerCount);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    DelayQueue<size_t> wheel;
+    vector<DelayQueue<size_t>::Timer *> handles(timerCount);
+
+    for (size_t iteration = 0; iteration < timerCount; iteration++)
+        handles[iteration] = wheel.schedule(iteration, deadlines[iteration]);
+    double wheelSchedule = elapsedMilliseconds(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < timerCount; iteration++)
+        if (cancelled[iteration])
+            wheel.cancel(handles[iteration]);
+    double wheelCancel = elapsedMilliseconds(start);
+
+    start = chrono::steady_clock::now();
+    for (uint64_t now = 0; now <= DEADLINE_SPAN; now += TICK_STEP)
+        wheel.advance(now, wheelOrder);
+    double wheelAdvance = elapsedMilliseconds(start);
+
+    // Binary heap, cancelling lazily by skipping flagged entries as they surface
+    vector<size_t> heapOrder;
+    heapOrder.reserve(timerCount);
+
+    start = chrono::steady_clock::now();
+    TimerHeap heap;
+    for (size_t iteration = 0; iteration < timerCount; iteration++)
+        heap.push(HeapEntry(deadlines[iteration], iteration));
+    double heapSchedule = elapsedMilliseconds(start);
+
+    start = chrono::steady_clock::now();
+    vector<bool> heapCancelled(timerCount);
+    for (size_t iteration = 0; iteration < timerCount; iteration++)
+        if (cancelled[iteration])
+            heapCancelled[iteration] = true;
+    double heapCancel = elapsedMilliseconds(start);
+
+    start = chrono::steady_clock::now();
+    for (uint64_t now = 0; now <= DEADLINE_SPAN; now += TICK_STEP)
+        while (!heap.empty() && heap.top().first <= now)
+        {
+            if (!heapCancelled[heap.top().second])
+                heapOrder.push_back(heap.top().second);
+
+            heap.pop();
+        }
+    double heapAdvance = elapsedMilliseconds(start);
+
+    // Both must expire the same timers in the same TICK_STEP batches; order inside a batch may differ
+    bool matches = wheelOrder.size() == heapOrder.size() && wheel.isEmpty();
+    for (size_t first = 0; matches && first < wheelOrder.size(); )
+    {
+        uint64_t batch = (deadlines[wheelOrder[first]] + TICK_STEP - 1) / TICK_STEP;
+        size_t last = first;
+
+        while (last < wheelOrder.size() && (deadlines[wheelOrder[last]] + TICK_STEP - 1) / TICK_STEP == batch)
+            ++last;
+
+        vector<size_t> lhs(wheelOrder.begin() + first, wheelOrder.begin() + last);
+        vector<size_t> rhs(heapOrder.begin() + first, heapOrder.begin() + last);
+        sort(lhs.begin(), lhs.end());
+        sort(rhs.begin(), rhs.end());
+
+        matches = lhs == rhs;
+        first = last;
+    }
+
+    cout << timerCount << " timers, " << wheelOrder.size() << " expired" << endl;
+    // The heap only flags cancelled timers and pays for them in advance, so its row says so
+    cout << "\t\t\tSchedule (ms)\tCancel (ms)\tAdvance (ms)" << endl;
+    cout << "Wheel\t\t\t" << wheelSchedule << "\t\t" << wheelCancel << "\t\t" << wheelAdvance << endl;
+    cout << "Heap, lazy cancel\t" << heapSchedule << "\t\t" << heapCancel << "\t\t" << heapAdvance << endl;
+    cout << "Results " << (matches ? "match" : "DIFFER") << endl;
+
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/**
+ *  @file dictionaryBuilderApp.cpp
+ *  @brief Tool that turns a tab separated word list into a MappedHashTable file.
+ *  @author Robert MacGregor
+ */
+
+#include <chrono>       // std::chrono::steady_clock
+#include <string>
+#include <fstream>      // std::ifstream
+#include <iostream>
+
+#include "MappedHashTable.h"
+
+using namespace std;
+
+/**
+ *  @brief Returns the number of milliseconds elapsed since start.
+ *  @param start The time point to measure from.
+ *  @return The elapsed milliseconds.
+ */
+static double elapsedMilliseconds(const chrono::steady_clock::time_point &start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ *  @brief Main entry point of the program.
+ *  @param argc The number of arguments that can be
+ *  found in argv.
+ *  @param argv The space-delineated parameter list passed
+ *  in the operating system. The first argument is the word list, with one word, a tab and its
+ *  definition per line, and the second the dictionary file to write.
+ *  @return An integer representing the return status.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        cout << "Usage: " << argv[0] << " <Word List> <Dictionary File>" << endl;
+        return 1;
+    }
+
+    ifstream input(argv[1]);
+    if (!input)
+    {
+        cout << "Error: No such file '" << argv[1] << "'" << endl;
+        return -1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    MappedHashTableWriter writer;
+    size_t skipped = 0;
+
+    string line;
+    while (getline(input, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+
+        size_t tab = line.find('\t');
+        if (tab == string::npos || !tab)
+        {
+            if (!line.empty())
+                ++skipped;
+
+            continue;
+        }
+
+        writer.add(string_view(line).substr(0, tab), string_view(line).substr(tab + 1));
+    }
+
+    cout << "Read " << writer.getSize() << " words in " << elapsedMilliseconds(start) << " ms";
+    if (skipped)
+        cout << ", skipped " << skipped << " lines without a tab";
+    cout << endl;
+
+    start = chrono::steady_clock::now();
+    if (!writer.write(argv[2]))
+    {
+        cout << "Error: Could not write '" << argv[2] << "'" << endl;
+        return -2;
+    }
+
+    cout << "Wrote " << argv[2] << " in " << elapsedMilliseconds(start) << " ms" << endl;
+
+    // Opening the result is all a program using it has to do at startup
+    start = chrono::steady_clock::now();
+    MappedHashTable table;
+    if (!table.open(argv[2]))
+    {
+        cout << "Error: '" << argv[2] << "' could not be opened again" << endl;
+        return -3;
+    }
+
+    cout << "Opened " << table.getSize() << " distinct words in " << elapsedMilliseconds(start) << " ms" << endl;
+    return 0;
+}
@@ -4,10 +4,27 @@
  *  @author Robert MacGregor
  */
 
+#include <chrono>       // std::chrono::steady_clock
 #include <string>
+#include <thread>       // std::thread
+#include <vector>       // std::vector
+#include <cstdio>       // fwrite
+#include <cstdlib>      // strtoul
+#include <cstring>      // strcmp
+#include <fstream>      // std::ifstream
 #include <iostream>
-
-#include "HashTable.h"
+#include <iterator>     // std::istreambuf_iterator
+#include <algorithm>    // std::sort
+
+#include "StaticHashTable.h"
+#include "OwningKeyedHashTable.h"
+#include "BulkLoader.h"
+#include "MappedHashTable.h"
+#include "DurableHashTable.h"
+#include "PrefixIndex.h"
+#include "FuzzyIndex.h"
+#include "IndexedHashTable.h"
+#include "Arena.h"
 
 using namespace std;
 
@@ -65,49 +82,284 @@ struct Dictionary
     }
 };
 
-//! Helper type used to populate the word list initially.
-typedef struct
+//! The words every dictionary starts with, laid out by a perfect hash while compiling.
+static constexpr auto initialWords = makeStaticHashTable<string_view>(
 {
-    string word;
-    string definition;
-} WordPairs;
+    { "Phone", "Make Calls" },
+    { "Computer", "Do Computations" },
+    { "Programming", "Write Code" },
+    { "Test", "Make sure it works!"},
+    { "Dive", "Leap in head first!"},
+    { "Slap", " ... with a wet fish!"},
+    { "Decompile", "Machine Code -> Human Readable Code"},
+    { "Compile", "Human Readable Code -> Machine Code"},
+    { "Processor", "Does mystical black magic things."},
+    { "Register", "Temporily stores a value."},
+    { "RAM", "Temporarily stores values"},
+    { "Word", "Verbal utterance with meaning"},
+    { "Key", "Keyboard button!"},
+    { "Light", "Luminous"},
+    { "Luma", "Light"},
+});
+
+//! The words added while running, by the word each Dictionary holds.
+typedef OwningKeyedHashTable<Dictionary, MemberKey<Dictionary, &Dictionary::word> > DictionaryTable;
+
+//! The students, by name, with indexes on their field and their quarter.
+typedef IndexedHashTable<Student, MemberKey<Student, &Student::name>,
+                         HashIndex<MemberField<Student, string, &Student::field> >,
+                         SortedIndex<MemberField<Student, int, &Student::quarter> > > StudentTable;
+
+//! The most words listed when completing a prefix.
+#define COMPLETION_LIMIT 10
+//! The most words suggested for a word that is not found.
+#define SUGGESTION_LIMIT 5
+//! The largest number of typing mistakes a suggestion may differ by.
+#define SUGGESTION_DISTANCE 2
+
+/**
+ *  @brief Returns a percentile of sorted samples.
+ *  @param samples The samples, sorted ascending. Must not be empty.
+ *  @param percentile The percentile to return, from 0 to 100.
+ *  @return The sample at that percentile.
+ */
+static double percentileOf(const vector<double> &samples, const double &percentile)
+{
+    size_t index = static_cast<size_t>(percentile / 100.0 * (samples.size() - 1));
+    return samples[index];
+}
+
+/**
+ *  @brief Looks up every word of a query file, split over several threads. Each word is written
+ *  to standard output on its own line, followed by a tab and its definition if it was found,
+ *  in the order of the file. A summary of the throughput and latency goes to standard error.
+ *  @param path The query file, with one word per line.
+ *  @param threadCount The number of threads to look words up on.
+ *  @param define The lookup, called as define(word, definition). It must be safe to call from
+ *  several threads at once.
+ *  @return A boolean representing whether or not the query file could be read.
+ */
+template <typename defineType>
+static bool runBatch(const char *path, size_t threadCount, const defineType &define)
+{
+    ifstream input(path, ios::binary);
+    if (!input)
+    {
+        cerr << "Error: No such file '" << path << "'" << endl;
+        return false;
+    }
+
+    string text((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    vector<string_view> queries;
+
+    for (size_t start = 0, end; start < text.size(); start = end + 1)
+    {
+        end = text.find('\n', start);
+        if (end == string::npos)
+            end = text.size();
+
+        string_view query(text.data() + start, end - start);
+        if (!query.empty() && query.back() == '\r')
+            query.remove_suffix(1);
+
+        if (!query.empty())
+            queries.push_back(query);
+    }
+
+    if (threadCount < 1)
+        threadCount = 1;
+    if (threadCount > queries.size() && !queries.empty())
+        threadCount = queries.size();
+
+    // Every thread formats its share of the results into its own buffer, written out in order at the end
+    vector<string> outputs(threadCount);
+    vector<vector<double> > latencies(threadCount);
+    vector<size_t> found(threadCount, 0);
+    vector<thread> threads;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t index = 0; index < threadCount; index++)
+    {
+        threads.push_back(thread([&, index]()
+        {
+            size_t first = queries.size() * index / threadCount;
+            size_t last = queries.size() * (index + 1) / threadCount;
+            string &output = outputs[index];
+
+            latencies[index].reserve(last - first);
+
+            for (size_t current = first; current < last; current++)
+            {
+                string_view definition;
+
+                chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+                bool defined = define(queries[current], definition);
+                latencies[index].push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count());
+
+                output += queries[current];
+                if (defined)
+                {
+                    output += '\t';
+                    output += definition;
+                    ++found[index];
+                }
+                output += '\n';
+            }
+        }));
+    }
+
+    for (size_t index = 0; index < threads.size(); index++)
+        threads[index].join();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t defined = 0;
+    vector<double> samples;
+    samples.reserve(queries.size());
+
+    for (size_t index = 0; index < threadCount; index++)
+    {
+        fwrite(outputs[index].data(), 1, outputs[index].size(), stdout);
+        samples.insert(samples.end(), latencies[index].begin(), latencies[index].end());
+        defined += found[index];
+    }
+    fflush(stdout);
+
+    cerr << "Looked up " << queries.size() << " words (" << defined << " found) on " << threadCount << " threads in "
+         << seconds * 1000 << " ms: " << (seconds > 0 ? queries.size() / seconds : 0) << " queries/s" << endl;
+
+    if (!samples.empty())
+    {
+        sort(samples.begin(), samples.end());
+        cerr << "Latency (ns): p50 " << percentileOf(samples, 50) << ", p90 " << percentileOf(samples, 90)
+             << ", p99 " << percentileOf(samples, 99) << ", p99.9 " << percentileOf(samples, 99.9)
+             << ", max " << samples.back() << endl;
+    }
+
+    return true;
+}
 
 /**
  *  @brief Main entry point of the program.
  *  @param argc The number of arguments that can be
  *  found in argv.
  *  @param argv The space-delineated parameter list passed
- *  in the operating system.
+ *  in the operating system. The optional first argument is a dictionary file written by
+ *  dictionaryBuilderApp, or a word list with a word, a tab and its definition per line, whose
+ *  words are looked up as well. With --store and a path, words added are also kept in files
+ *  under that path and restored the next time. With --queries and a file of words, one per line,
+ *  the program looks them all up instead of showing the menu, on as many threads as given with
+ *  --threads.
  */
 int main(int argc, char *argv[])
 {
-    HashTable<Dictionary> table;
-
-    WordPairs initialWords[] =
-    {
-        { "Phone", "Make Calls" },
-        { "Computer", "Do Computations" },
-        { "Programming", "Write Code" },
-        { "Test", "Make sure it works!"},
-        { "Dive", "Leap in head first!"},
-        { "Slap", " ... with a wet fish!"},
-        { "Decompile", "Machine Code -> Human Readable Code"},
-        { "Compile", "Human Readable Code -> Machine Code"},
-        { "Processor", "Does mystical black magic things."},
-        { "Register", "Temporily stores a value."},
-        { "RAM", "Temporarily stores values"},
-        { "Word", "Verbal utterance with meaning"},
-        { "Key", "Keyboard button!"},
-        { "Light", "Luminous"},
-        { "Luma", "Light"},
+    DictionaryTable table;
+    MappedHashTable dictionary;
+    BulkLoader loader;
+    HashTable<BulkLoader::Entry> loadedWords;
+    DurableHashTable store;
+
+    // Built from every source of words the first time it is needed, then kept up to date
+    PrefixIndex<Dictionary> completions;
+    bool completionsBuilt = false;
+
+    // Likewise built the first time a word is not found
+    FuzzyIndex suggestions(SUGGESTION_DISTANCE);
+    bool suggestionsBuilt = false;
+
+    // The static words cost a single probe, so they are checked first. Words added here take
+    // precedence over the dictionary file.
+    auto define = [&](string_view word, string_view &definition)
+    {
+        const string_view *initialDefinition = initialWords.find(word);
+        Dictionary *result = initialDefinition ? NULL : table.find(word);
+        BulkLoader::Entry *loaded = NULL;
+
+        if (initialDefinition)
+            definition = *initialDefinition;
+        else if (result)
+            definition = result->definition;
+        else if (dictionary.find(word, definition))
+            return true;
+        else if ((loaded = loadedWords.find(word)))
+            definition = loaded->getValue();
+        else
+            return false;
+
+        return true;
     };
 
-    // Add the words
-    for (size_t iteration = 0; iteration < sizeof(initialWords) / sizeof(WordPairs); iteration++)
-        table.add(initialWords[iteration].word,
-                  new Dictionary(initialWords[iteration].word, initialWords[iteration].definition));
+    const char *dictionaryPath = NULL;
+    const char *storePath = NULL;
+    const char *queriesPath = NULL;
+    size_t threadCount = 1;
+
+    for (int index = 1; index < argc; index++)
+    {
+        if (!strcmp(argv[index], "--store") && index + 1 < argc)
+            storePath = argv[++index];
+        else if (!strcmp(argv[index], "--queries") && index + 1 < argc)
+            queriesPath = argv[++index];
+        else if (!strcmp(argv[index], "--threads") && index + 1 < argc)
+            threadCount = strtoul(argv[++index], NULL, 10);
+        else
+            dictionaryPath = argv[index];
+    }
+
+    // Batch results go to standard output, so everything else goes to standard error then
+    ostream &status = queriesPath ? cerr : cout;
+
+    if (dictionaryPath)
+    {
+        if (dictionary.open(dictionaryPath))
+            status << "Loaded " << dictionary.getSize() << " words from '" << dictionaryPath << "'" << endl;
+        else if (loader.open(dictionaryPath))
+        {
+            loader.loadInto(loadedWords);
+            status << "Loaded " << loadedWords.getSize() << " words from '" << dictionaryPath << "'" << endl;
+        }
+        else
+            status << "Error: No such file '" << dictionaryPath << "'" << endl;
+    }
+
+    if (storePath)
+    {
+        if (store.open(storePath))
+        {
+            store.forEach([&table](string_view word, string_view definition)
+            {
+                table.emplace(string(word), string(definition));
+            });
+            status << "Restored " << store.getSize() << " words from '" << storePath << "'" << endl;
+        }
+        else
+            status << "Error: Cannot keep words in '" << storePath << "'" << endl;
+    }
+
+    if (queriesPath)
+    {
+        // With no migration pending, find() only reads and the lookups may run side by side. The
+        // added words never migrate.
+        loadedWords.completeMigration();
+
+        return runBatch(queriesPath, threadCount, define) ? 0 : 1;
+    }
+
+    // The roster is the only index by name; the arena just keeps the Students
+    ObjectArena<Student> students;
+    StudentTable roster;
+
+    for (const Student &student : { Student("Ada", "Mathematics", 3), Student("Alan", "Computer Science", 5),
+                                     Student("Grace", "Computer Science", 2), Student("Edsger", "Computer Science", 7),
+                                     Student("Emmy", "Mathematics", 6), Student("Marie", "Chemistry", 4),
+                                     Student("Rosalind", "Chemistry", 2), Student("Richard", "Physics", 5) })
+        roster.add(students.create(student));
 
-    cout << table << endl;
+    // The initial words live in initialWords; only words added later go into the table
+    initialWords.forEach([](string_view word, const string_view &definition)
+    {
+        cout << word << " means " << definition << endl;
+    });
 
     // Query the user for their choice
     int userChoice = -1;
@@ -117,6 +369,10 @@ int main(int argc, char *argv[])
         cout << "0.) Quit" << endl;
         cout << "1.) Add a Word" << endl;
         cout << "2.) Find a Word" << endl;
+        cout << "3.) Complete a Word" << endl;
+        cout << "4.) Show Table Statistics" << endl;
+        cout << "5.) Find Students by Field" << endl;
+        cout << "6.) Find Students by Quarter" << endl;
         cout << "Choice: ";
 
         cin >> userChoice;
@@ -135,8 +391,21 @@ int main(int argc, char *argv[])
                 cout << "Type a definition: ";
                 cin.getline(definition, sizeof(definition) / sizeof(char));
 
-                // Add the Lookup
-                table.add(word, new Dictionary(word, definition));
+                // Add the Lookup, replacing any earlier definition
+                if (initialWords.contains(word))
+                    cout << "'" << word << "' is a built in word and cannot be redefined!" << endl;
+                else
+                {
+                    // Logged before the table changes, so a word reported as added is never lost
+                    if (store.isOpen() && (!store.add(word, definition) || !store.commit()))
+                        cout << "Warning: '" << word << "' could not be saved!" << endl;
+
+                    Dictionary &added = table.emplace(word, definition);
+                    if (completionsBuilt)
+                        completions.add(added.word, &added);
+                    if (suggestionsBuilt)
+                        suggestions.add(added.word);
+                }
                 break;
             }
 
@@ -147,12 +416,131 @@ int main(int argc, char *argv[])
                 cout << "Type a word: ";
                 cin >> word;
 
-                Dictionary *result = table.find(word);
-
-                if (!result)
-                    cout << "No such word: '" << word << "'!" << endl;
+                string_view definition;
+                if (define(word, definition))
+                    cout << word << " means " << definition << endl;
                 else
-                    cout << word << " means " << result->definition << endl;
+                {
+                    cout << "No such word: '" << word << "'!" << endl;
+
+                    if (!suggestionsBuilt)
+                    {
+                        initialWords.forEach([&suggestions](string_view word, const string_view &)
+                        {
+                            suggestions.add(word);
+                        });
+                        dictionary.forEach([&suggestions](string_view word, string_view)
+                        {
+                            suggestions.add(word);
+                        });
+                        loadedWords.forEach([&suggestions](const string &word, BulkLoader::Entry *)
+                        {
+                            suggestions.add(word);
+                        });
+                        table.forEach([&suggestions](const string &word, Dictionary *)
+                        {
+                            suggestions.add(word);
+                        });
+                        suggestions.build();
+                        suggestionsBuilt = true;
+                    }
+
+                    vector<FuzzyIndex::Match> matches = suggestions.search(word, SUGGESTION_DISTANCE);
+                    for (size_t index = 0; index < matches.size() && index < SUGGESTION_LIMIT; index++)
+                        cout << (index ? ", " : "Did you mean: ") << matches[index].key;
+
+                    if (!matches.empty())
+                        cout << "?" << endl;
+                }
+
+                break;
+            }
+
+            case 3: // Complete a word
+            {
+                string prefix;
+
+                cout << "Type the start of a word: ";
+                cin >> prefix;
+
+                if (!completionsBuilt)
+                {
+                    initialWords.forEach([&completions](string_view word, const string_view &)
+                    {
+                        completions.add(word, NULL);
+                    });
+                    dictionary.forEach([&completions](string_view word, string_view)
+                    {
+                        completions.add(word, NULL);
+                    });
+                    loadedWords.forEach([&completions](const string &word, BulkLoader::Entry *)
+                    {
+                        completions.add(word, NULL);
+                    });
+                    completions.addAll(table);
+                    completionsBuilt = true;
+                }
+
+                size_t count = completions.forEachWithPrefix(prefix, COMPLETION_LIMIT,
+                                                             [&define](const string &word, Dictionary *)
+                {
+                    string_view definition;
+                    if (define(word, definition))
+                        cout << word << " means " << definition << endl;
+                });
+
+                if (!count)
+                    cout << "No words start with '" << prefix << "'!" << endl;
+
+                break;
+            }
+
+            case 4: // Show table statistics
+            {
+                cout << "Added words: " << table.getStatistics().toJSON() << endl;
+
+                if (!loadedWords.isEmpty())
+                    cout << "Loaded words: " << loadedWords.getStatistics().toJSON() << endl;
+
+                break;
+            }
+
+            case 5: // Find students by field
+            {
+                char field[256];
+
+                cout << "Type a field of study: ";
+                cin.ignore(256, '\n');
+                cin.getline(field, sizeof(field) / sizeof(char));
+
+                size_t count = roster.getIndex<0>().forEach(field, [](Student *student)
+                {
+                    cout << *student << endl;
+                });
+
+                if (!count)
+                    cout << "No students study '" << field << "'!" << endl;
+
+                break;
+            }
+
+            case 6: // Find students by quarter
+            {
+                int first;
+                int last;
+
+                cout << "From quarter: ";
+                cin >> first;
+                cout << "To quarter: ";
+                cin >> last;
+
+                size_t count = roster.getIndex<1>().forEachInRange(first, last, [](Student *student)
+                {
+                    cout << *student << endl;
+                });
+
+                if (!count)
+                    cout << "No students are between Q" << first << " and Q" << last << "!" << endl;
 
                 break;
             }
@@ -167,5 +555,7 @@ int main(int argc, char *argv[])
         }
     }
 
+    // The arena does not destroy the Students it still holds
+    roster.forEach([&students](Student *student) { students.destroy(student); });
     return 0;
 }
@@ -0,0 +1,1305 @@
+/**
+ *  @file hashTableBenchmarkApp.cpp
+ *  @brief Driver that measures the HashTable implementations against each other.
+ *  @author Robert MacGregor
+ */
+
+#include <cmath>        // pow
+#include <chrono>       // std::chrono::steady_clock
+#include <random>       // std::mt19937_64
+#include <string>
+#include <mutex>        // std::mutex, std::lock_guard
+#include <thread>       // std::thread
+#include <vector>       // std::vector
+#include <cstdio>       // remove
+#include <cstring>      // strcmp
+#include <ctime>        // clock_gettime
+#include <fstream>      // std::ifstream, std::ofstream
+#include <sstream>      // std::ostringstream
+#include <iostream>
+#include <algorithm>    // std::sort, std::shuffle, std::lower_bound
+
+#ifdef __GLIBC__
+#include <malloc.h>     // mallinfo2
+#endif
+
+#include "Hashers.h"
+#include "HashTable.h"
+#include "BulkLoader.h"
+#include "DurableHashTable.h"
+#include "LRUCache.h"
+#include "FilteredHashTable.h"
+#include "FuzzyIndex.h"
+#include "InternedHashTable.h"
+#include "SwissHashTable.h"
+#include "PersistentHashTable.h"
+#include "LockFreeHashTable.h"
+#include "ConcurrentHashTable.h"
+
+using namespace std;
+
+//! The number of Buckets the tables are sized to for the probe benchmark.
+#define PROBE_CAPACITY (1 << 20)
+//! The number of lookups timed per measurement.
+#define LOOKUP_COUNT 2000000
+//! The number of keys inserted by the growth benchmark.
+#define GROWTH_COUNT 4000000
+//! The number of keys preloaded by the concurrency benchmark.
+#define CONCURRENT_KEY_COUNT (1 << 20)
+//! The number of operations each thread performs in the concurrency benchmark.
+#define CONCURRENT_OPERATION_COUNT 500000
+//! The number of keys stored by each table in the interning benchmark.
+#define INTERN_KEY_COUNT 1000000
+//! The number of keys the interning benchmark prints from the key arena.
+#define INTERN_DUMP_COUNT 8
+//! The number of keys hashed by the hash benchmark when no key file is given.
+#define HASH_KEY_COUNT (1 << 20)
+//! The hash benchmark hashes the key set over and over until it has covered this many bytes.
+#define HASH_THROUGHPUT_BYTES (1 << 28)
+//! The number of lines in the file the bulk benchmark generates when no file is given.
+#define BULK_LINE_COUNT 10000000
+//! The file the bulk benchmark generates, removed again when it is done.
+#define BULK_FILE "hashTableBenchmark.tsv"
+//! The number of distinct keys requested in the cache benchmark.
+#define CACHE_KEY_COUNT (1 << 20)
+//! The number of requests made to each cache in the cache benchmark.
+#define CACHE_REQUEST_COUNT 4000000
+//! The exponent of the Zipf distribution the cache benchmark draws its requests from.
+#define CACHE_SKEW 0.99
+//! The number of keys stored by the Bloom filter benchmark.
+#define BLOOM_KEY_COUNT (1 << 21)
+//! The percentage of lookups in the Bloom filter benchmark that are for absent keys.
+#define BLOOM_MISS_PERCENT 90
+//! The number of keys indexed by the fuzzy search benchmark.
+#define FUZZY_KEY_COUNT 1000000
+//! The number of misspelled queries timed by the fuzzy search benchmark.
+#define FUZZY_QUERY_COUNT 20000
+//! The number of those queries also answered by comparing against every key.
+#define FUZZY_SCAN_COUNT 50
+//! The number of keys in the table of the batch lookup benchmark, whose Buckets take several hundred MiB.
+#define BATCH_KEY_COUNT (1 << 22)
+//! The largest batch the batch lookup benchmark tries.
+#define MAX_BATCH_SIZE 64
+//! The number of keys added in the snapshot benchmark.
+#define SNAPSHOT_KEY_COUNT (1 << 20)
+//! The number of adds between the snapshots handed to the dumping thread.
+#define SNAPSHOT_INTERVAL 65536
+//! The number of commits made by each thread count in the durability benchmark.
+#define DURABLE_COMMIT_COUNT 4096
+//! The number of words added to a DurableHashTable in the durability benchmark.
+#define DURABLE_KEY_COUNT 500000
+//! The number of adds per commit when adding those words.
+#define DURABLE_BATCH_SIZE 64
+//! The path the durability benchmark keeps its files under.
+#define DURABLE_FILE "hashTableBenchmark.durable"
+
+/**
+ *  @brief Returns the number of nanoseconds elapsed since start.
+ *  @param start The time point to measure from.
+ *  @return The elapsed nanoseconds.
+ */
+static double elapsedNanoseconds(const chrono::steady_clock::time_point &start)
+{
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ *  @brief Returns the CPU time the calling thread has used so far, which unlike the wall clock
+ *  leaves out the time other threads spend on the same cores.
+ *  @return The CPU time in nanoseconds.
+ */
+static double threadCpuNanoseconds(void)
+{
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+/**
+ *  @brief Returns the number of bytes the heap has handed out, including the allocator's own
+ *  bookkeeping and whatever it cannot reuse between the allocations.
+ *  @return The bytes in use, or zero where the C library does not report them.
+ */
+static size_t heapBytesInUse(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 information = mallinfo2();
+    return information.uordblks + information.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/**
+ *  @brief Produces count distinct lowercase words, which stand in for dictionary keys.
+ *  @param count The number of words to produce.
+ *  @param seed Seeds the word lengths and letters.
+ *  @param prefix Prepended to every word, so that word sets with different prefixes never overlap.
+ *  @return The words.
+ */
+static vector<string> makeWords(const size_t &count, const uint64_t &seed, const string &prefix)
+{
+    mt19937_64 generator(seed);
+    vector<string> result;
+    result.reserve(count);
+
+    size_t width = 1;
+    for (size_t limit = 26; limit < count; limit *= 26)
+        ++width;
+
+    for (size_t iteration = 0; iteration < count; iteration++)
+    {
+        // The index is spelled out in fixed width base 26 so every word is unique, then padded with noise
+        string word = prefix;
+        for (size_t digit = 0, value = iteration; digit < width; digit++, value /= 26)
+            word += static_cast<char>('a' + value % 26);
+
+        for (size_t padding = generator() % 8; padding; padding--)
+            word += static_cast<char>('a' + generator() % 26);
+
+        result.push_back(word);
+    }
+
+    return result;
+}
+
+/**
+ *  @brief Times find() over a list of keys.
+ *  @param table The table to search.
+ *  @param keys The keys to look up, in order.
+ *  @param found Assigned the number of keys that were present.
+ *  @return The average nanoseconds per lookup.
+ */
+template <typename tableType>
+static double timeLookups(const tableType &table, const vector<string> &keys, size_t &found)
+{
+    found = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < keys.size(); iteration++)
+        if (table.find(keys[iteration]))
+            ++found;
+
+    return elapsedNanoseconds(start) / keys.size();
+}
+
+/**
+ *  @brief Compares hit and miss lookup latency of HashTable and SwissHashTable at several
+ *  load factors.
+ */
+static void runProbeBenchmark(void)
+{
+    static const double loadFactors[] = { 0.5, 0.625, 0.75, 0.875 };
+
+    vector<string> words = makeWords(PROBE_CAPACITY, 1, "");
+    vector<string> absent = makeWords(LOOKUP_COUNT, 2, "_");
+    int value = 0;
+
+    cout << "Load\tTable\tHit (ns)\tMiss (ns)" << endl;
+    for (size_t test = 0; test < sizeof(loadFactors) / sizeof(double); test++)
+    {
+        size_t count = static_cast<size_t>(PROBE_CAPACITY * loadFactors[test]);
+
+        HashTable<int> scalar(PROBE_CAPACITY);
+        SwissHashTable<int> swiss(PROBE_CAPACITY);
+
+        for (size_t iteration = 0; iteration < count; iteration++)
+        {
+            scalar.add(words[iteration], &value);
+            swiss.add(words[iteration], &value);
+        }
+
+        mt19937_64 generator(3);
+        vector<string> present;
+        present.reserve(LOOKUP_COUNT);
+
+        for (size_t iteration = 0; iteration < LOOKUP_COUNT; iteration++)
+            present.push_back(words[generator() % count]);
+
+        size_t scalarHits, scalarMisses, swissHits, swissMisses;
+        double scalarHit = timeLookups(scalar, present, scalarHits);
+        double scalarMiss = timeLookups(scalar, absent, scalarMisses);
+        double swissHit = timeLookups(swiss, present, swissHits);
+        double swissMiss = timeLookups(swiss, absent, swissMisses);
+
+        if (scalarHits != LOOKUP_COUNT || swissHits != LOOKUP_COUNT || scalarMisses || swissMisses)
+            cout << "Lookup results are wrong!" << endl;
+
+        cout << loadFactors[test] << "\tScalar\t" << scalarHit << "\t\t" << scalarMiss << endl;
+        cout << loadFactors[test] << "\tSwiss\t" << swissHit << "\t\t" << swissMiss << endl;
+    }
+}
+
+/**
+ *  @brief Returns the value at a percentile of a sorted list of samples.
+ *  @param samples The samples, sorted in ascending order.
+ *  @param percentile The percentile to read, between 0 and 100.
+ *  @return The sample at that percentile.
+ */
+static double percentileOf(const vector<double> &samples, const double &percentile)
+{
+    size_t index = static_cast<size_t>(percentile / 100.0 * (samples.size() - 1));
+    return samples[index];
+}
+
+/**
+ *  @brief Times every add() while a HashTable grows from empty, showing that incremental
+ *  migration keeps the tail latency flat, and samples the migration progress on the way.
+ */
+static void runGrowthBenchmark(void)
+{
+    vector<string> words = makeWords(GROWTH_COUNT, 4, "");
+    vector<double> latencies(GROWTH_COUNT);
+    HashTable<int> table;
+    int value = 0;
+
+    for (size_t iteration = 0; iteration < GROWTH_COUNT; iteration++)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        table.add(words[iteration], &value);
+        latencies[iteration] = elapsedNanoseconds(start);
+
+        if ((iteration + 1) % (GROWTH_COUNT / 8) == 0)
+        {
+            HashTable<int>::Statistics statistics = table.getStatistics();
+
+            cout << statistics.size << " keys, " << statistics.capacity << " buckets, migration ";
+            if (statistics.migrating)
+                cout << statistics.migratedBuckets << "/" << statistics.migrationBuckets << " ("
+                     << statistics.migrationProgress * 100 << "%)" << endl;
+            else
+                cout << "idle" << endl;
+        }
+    }
+
+    sort(latencies.begin(), latencies.end());
+    cout << "Insert latency (ns): p50 " << percentileOf(latencies, 50) << ", p99 " << percentileOf(latencies, 99)
+         << ", p99.9 " << percentileOf(latencies, 99.9) << ", max " << latencies.back() << endl;
+}
+
+/**
+ *  @brief Runs a random mix of lookups and value replacing adds on a preloaded table from
+ *  several threads at once.
+ *  @param table The table to work on. It must already hold every key in words.
+ *  @param words The keys to operate on.
+ *  @param threadCount The number of threads to run.
+ *  @param readPercentage The percentage of operations that are lookups.
+ *  @return The combined throughput in millions of operations per second.
+ */
+template <typename tableType>
+static double measureMixedWorkload(tableType &table, const vector<string> &words, const size_t &threadCount,
+                                   const size_t &readPercentage)
+{
+    static int value = 0;
+    vector<thread> threads;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t threadIndex = 0; threadIndex < threadCount; threadIndex++)
+        threads.push_back(thread([&table, &words, threadIndex, readPercentage]()
+        {
+            mt19937_64 generator(threadIndex + 1);
+            size_t found = 0;
+
+            // Writes replace the values of existing keys so the table size stays put
+            for (size_t operation = 0; operation < CONCURRENT_OPERATION_COUNT; operation++)
+            {
+                uint64_t random = generator();
+                const string &key = words[random % words.size()];
+
+                if ((random >> 40) % 100 < readPercentage)
+                    found += table.find(key) != NULL;
+                else
+                    table.add(key, &value);
+            }
+
+            if (found > CONCURRENT_OPERATION_COUNT)
+                cout << "Impossible" << endl;
+        }));
+
+    for (size_t threadIndex = 0; threadIndex < threadCount; threadIndex++)
+        threads[threadIndex].join();
+
+    double seconds = elapsedNanoseconds(start) / 1e9;
+    return threadCount * CONCURRENT_OPERATION_COUNT / seconds / 1e6;
+}
+
+/**
+ *  @brief Preloads a table and prints its throughput for growing thread counts at several
+ *  read/write mixes.
+ *  @param name The name to print for the table.
+ *  @param table The empty table to measure.
+ *  @param words The keys to preload and operate on.
+ */
+template <typename tableType>
+static void runMixedWorkloads(const string &name, tableType &table, const vector<string> &words)
+{
+    static const size_t threadCounts[] = { 1, 2, 4, 8, 16 };
+    static const size_t readPercentages[] = { 100, 95, 50 };
+    static int value = 0;
+
+    for (size_t iteration = 0; iteration < words.size(); iteration++)
+        table.add(words[iteration], &value);
+
+    for (size_t mixTest = 0; mixTest < sizeof(readPercentages) / sizeof(size_t); mixTest++)
+        for (size_t threadTest = 0; threadTest < sizeof(threadCounts) / sizeof(size_t); threadTest++)
+            cout << name << "\t" << readPercentages[mixTest] << "\t" << threadCounts[threadTest] << "\t"
+                 << measureMixedWorkload(table, words, threadCounts[threadTest], readPercentages[mixTest]) << endl;
+}
+
+/**
+ *  @brief Measures the throughput of the thread safe tables for growing thread counts at several
+ *  read/write mixes. A ConcurrentHashTable with a single shard is the baseline for one big lock.
+ */
+static void runConcurrentBenchmark(void)
+{
+    vector<string> words = makeWords(CONCURRENT_KEY_COUNT, 5, "");
+
+    cout << "Hardware threads: " << thread::hardware_concurrency() << endl;
+    cout << "Table\t\tRead%\tThreads\tMops/s" << endl;
+
+    {
+        ConcurrentHashTable<int> table(1);
+        runMixedWorkloads("Sharded x1", table, words);
+    }
+
+    {
+        ConcurrentHashTable<int> table(64);
+        runMixedWorkloads("Sharded x64", table, words);
+    }
+
+    {
+        LockFreeHashTable<int> table;
+        runMixedWorkloads("Lock free", table, words);
+    }
+}
+
+/**
+ *  @brief Builds a table from a key set and prints the time per add and per lookup, and the heap
+ *  taken by the table and its keys.
+ *  @param name The name to print for the table.
+ *  @param keys The distinct keys to add.
+ */
+template <typename tableType>
+static void measureKeyStorage(const string &name, const vector<string> &keys)
+{
+    int value = 0;
+    size_t before = heapBytesInUse();
+
+    tableType table(keys.size() * 8 / 7 + 1);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < keys.size(); iteration++)
+        table.add(keys[iteration], &value);
+
+    double add = elapsedNanoseconds(start) / keys.size();
+    size_t bytes = heapBytesInUse() - before;
+
+    size_t found;
+    double lookup = timeLookups(table, keys, found);
+
+    cout << name << "\t" << add << "\t" << lookup << (found == keys.size() ? "" : " (lookups failed!)") << "\t";
+    if (before)
+        cout << bytes / static_cast<double>(1 << 20) << "\t\t" << static_cast<double>(bytes) / keys.size() << endl;
+    else
+        cout << "-\t\t-" << endl;
+}
+
+/**
+ *  @brief Compares the time and heap of HashTable, which allocates a std::string per key, against
+ *  InternedHashTable, which packs the keys into one StringArena, for short and long keys. Then
+ *  prints the start of the arena.
+ */
+static void runInternBenchmark(void)
+{
+    // Short words fit in std::string's own buffer, paths do not and cost an allocation each
+    vector<string> words = makeWords(INTERN_KEY_COUNT, 18, "");
+    vector<string> paths = makeWords(INTERN_KEY_COUNT, 19, "/usr/share/dict/words/");
+
+    cout << "Keys\tTable\t\t\tAdd ns\tFind ns\tHeap MiB\tBytes/key" << endl;
+
+    measureKeyStorage<HashTable<int>>("Words\tHashTable\t", words);
+    measureKeyStorage<InternedHashTable<int>>("Words\tInternedHashTable", words);
+    measureKeyStorage<HashTable<int>>("Paths\tHashTable\t", paths);
+    measureKeyStorage<InternedHashTable<int>>("Paths\tInternedHashTable", paths);
+
+    InternedHashTable<int> table;
+    int value = 0;
+    for (size_t iteration = 0; iteration < paths.size(); iteration++)
+        table.add(paths[iteration], &value);
+
+    // Removed keys stay in the arena as dead bytes until it is compacted
+    for (size_t iteration = 0; iteration < paths.size(); iteration += 4)
+        table.remove(paths[iteration]);
+
+    const StringArena &arena = table.getKeys();
+    cout << endl << table.getSize() << " paths after removing every fourth, key arena of "
+         << arena.getSize() << " bytes (" << arena.getDeadBytes() << " dead) in a buffer of "
+         << arena.getCapacity() << ":" << endl;
+    cout << "Offset\tHash\t\tKey" << endl;
+
+    size_t dumped = 0;
+    arena.forEach([&dumped](const size_t &offset, string_view key, const uint32_t &hash)
+    {
+        if (dumped++ < INTERN_DUMP_COUNT)
+            cout << offset << "\t" << hex << hash << dec << "\t" << key << endl;
+    });
+}
+
+/**
+ *  @brief Simulates inserting hashes into a HashTable sized the way HashTable would size itself
+ *  for that many keys, and counts how far each ended up from its home Bucket.
+ *  @param hashes The 32 bit hashes to insert.
+ *  @return The number of entries at each probe length, indexed by probe length. A probe length
+ *  of one is an entry sitting in its home Bucket.
+ */
+static vector<size_t> probeLengthHistogram(const vector<uint32_t> &hashes)
+{
+    size_t capacity = 8;
+    while (hashes.size() * 8 > capacity * 7)
+        capacity <<= 1;
+
+    vector<uint32_t> bucketHashes(capacity);
+    vector<uint32_t> distances(capacity, 0);
+
+    // The same Robin Hood displacement HashTable::insert() performs
+    for (size_t iteration = 0; iteration < hashes.size(); iteration++)
+    {
+        uint32_t hash = hashes[iteration];
+        uint32_t distance = 1;
+
+        for (size_t current = hash & (capacity - 1); ; current = (current + 1) & (capacity - 1), distance++)
+        {
+            if (!distances[current])
+            {
+                bucketHashes[current] = hash;
+                distances[current] = distance;
+                break;
+            }
+
+            if (distances[current] < distance)
+            {
+                swap(bucketHashes[current], hash);
+                swap(distances[current], distance);
+            }
+        }
+    }
+
+    vector<size_t> result;
+    for (size_t index = 0; index < capacity; index++)
+        if (distances[index])
+        {
+            if (result.size() <= distances[index])
+                result.resize(distances[index] + 1);
+
+            ++result[distances[index]];
+        }
+
+    return result;
+}
+
+/**
+ *  @brief Counts the values of a list that repeat an earlier value.
+ *  @param values The values. They are sorted in place.
+ *  @return The number of values equal to some other value before them.
+ */
+template <typename valueType>
+static size_t countCollisions(vector<valueType> &values)
+{
+    sort(values.begin(), values.end());
+
+    size_t result = 0;
+    for (size_t index = 1; index < values.size(); index++)
+        if (values[index] == values[index - 1])
+            ++result;
+
+    return result;
+}
+
+/**
+ *  @brief Prints the hashing throughput, lookup latency, collisions and probe length
+ *  distribution of one hasher over a key set.
+ *  @param name The name to print for the hasher.
+ *  @param keys The distinct keys to hash.
+ */
+template <typename hasherType>
+static void measureHasher(const string &name, const vector<string> &keys)
+{
+    size_t bytes = 0;
+    for (size_t iteration = 0; iteration < keys.size(); iteration++)
+        bytes += keys[iteration].size();
+
+    size_t rounds = 1 + HASH_THROUGHPUT_BYTES / (bytes + keys.size());
+    uint64_t checksum = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++)
+        for (size_t iteration = 0; iteration < keys.size(); iteration++)
+            checksum += hasherType::hash(keys[iteration].data(), keys[iteration].size());
+
+    double nanoseconds = elapsedNanoseconds(start);
+
+    vector<uint64_t> fullHashes;
+    vector<uint32_t> tableHashes;
+    fullHashes.reserve(keys.size());
+    tableHashes.reserve(keys.size());
+
+    for (size_t iteration = 0; iteration < keys.size(); iteration++)
+    {
+        fullHashes.push_back(hasherType::hash(keys[iteration].data(), keys[iteration].size()));
+        tableHashes.push_back(HashTable<int, hasherType>::hashKey(keys[iteration].data(), keys[iteration].size()));
+    }
+
+    vector<size_t> histogram = probeLengthHistogram(tableHashes);
+
+    HashTable<int, hasherType> table(keys.size() * 8 / 7 + 1);
+    int value = 0;
+    for (size_t iteration = 0; iteration < keys.size(); iteration++)
+        table.add(keys[iteration], &value);
+
+    size_t found;
+    double lookup = timeLookups(table, keys, found);
+
+    double probeTotal = 0;
+    for (size_t length = 1; length < histogram.size(); length++)
+        probeTotal += static_cast<double>(length) * histogram[length];
+
+    cout << name << ":" << endl;
+    cout << "\tHashing: " << nanoseconds / (rounds * keys.size()) << " ns/key, "
+         << rounds * bytes / (nanoseconds / 1e9) / (1 << 20) << " MiB/s (checksum " << (checksum & 0xFFFF) << ")" << endl;
+    cout << "\tHashTable lookup: " << lookup << " ns" << (found == keys.size() ? "" : " (lookups failed!)") << endl;
+    cout << "\tCollisions: " << countCollisions(fullHashes) << " of 64 bits, " << countCollisions(tableHashes)
+         << " of the 32 bits HashTable keeps" << endl;
+    cout << "\tProbe length: mean " << probeTotal / keys.size() << ", max " << histogram.size() - 1 << endl;
+
+    for (size_t length = 1; length < histogram.size(); length++)
+        cout << "\t\t" << length << "\t" << histogram[length] << endl;
+}
+
+/**
+ *  @brief Compares the bundled hashers over the keys of a file, or over generated words when no
+ *  file is given.
+ *  @param path The file to read keys from, one per line, or NULL.
+ *  @return A boolean representing whether or not the keys could be read.
+ */
+static bool runHashBenchmark(const char *path)
+{
+    vector<string> keys;
+
+    if (path)
+    {
+        ifstream input(path);
+        if (!input)
+        {
+            cout << "Could not open " << path << endl;
+            return false;
+        }
+
+        string line;
+        while (getline(input, line))
+        {
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+
+            if (!line.empty())
+                keys.push_back(line);
+        }
+
+        // Repeated keys would otherwise count as collisions
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    }
+    else
+        keys = makeWords(HASH_KEY_COUNT, 6, "");
+
+    if (keys.empty())
+    {
+        cout << "No keys to hash" << endl;
+        return false;
+    }
+
+    cout << keys.size() << " distinct keys" << endl;
+    measureHasher<FNV1aHasher>("FNV-1a", keys);
+    measureHasher<WyHasher>("WyHasher", keys);
+    return true;
+}
+
+/**
+ *  @brief Writes a tab separated dictionary file of distinct generated words.
+ *  @param path The file to write.
+ *  @param count The number of lines to write.
+ *  @return A boolean representing whether or not the file was written.
+ */
+static bool writeDictionaryFile(const string &path, const size_t &count)
+{
+    ofstream output(path.c_str(), ios::binary | ios::trunc);
+    mt19937_64 generator(7);
+    string line;
+
+    for (size_t iteration = 0; iteration < count && output; iteration++)
+    {
+        // A fixed width base 26 spelling of the line number keeps every word distinct
+        line.clear();
+        for (size_t digit = 0, value = iteration; digit < 6; digit++, value /= 26)
+            line += static_cast<char>('a' + value % 26);
+
+        for (size_t padding = generator() % 6; padding; padding--)
+            line += static_cast<char>('a' + generator() % 26);
+
+        line += "\tThe meaning of entry ";
+        line += to_string(iteration);
+        line += '\n';
+
+        output.write(line.data(), line.size());
+    }
+
+    output.close();
+    return static_cast<bool>(output);
+}
+
+/**
+ *  @brief Times parsing a dictionary file with a BulkLoader and loading it into tables, against
+ *  a single threaded load that lets the HashTable grow as it goes.
+ *  @param path The tab separated file to load, or NULL to generate one of BULK_LINE_COUNT lines.
+ *  @return A boolean representing whether or not the file could be loaded.
+ */
+static bool runBulkBenchmark(const char *path)
+{
+    string file = path ? path : BULK_FILE;
+
+    if (!path)
+    {
+        cout << "Writing " << BULK_LINE_COUNT << " lines to " << file << endl;
+        if (!writeDictionaryFile(file, BULK_LINE_COUNT))
+        {
+            cout << "Could not write " << file << endl;
+            return false;
+        }
+    }
+
+    size_t threadCounts[] = { 1, thread::hardware_concurrency() };
+    size_t distinct = 0;
+    bool result = true;
+
+    for (size_t test = 0; test < sizeof(threadCounts) / sizeof(size_t) && result; test++)
+    {
+        if (test && threadCounts[test] <= 1)
+            break;
+
+        BulkLoader loader(threadCounts[test]);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (!loader.open(file))
+        {
+            cout << "Could not open " << file << endl;
+            result = false;
+            break;
+        }
+
+        cout << loader.getThreadCount() << " thread(s): parsed " << loader.getSize() << " lines in "
+             << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+        // The baseline inserts one line at a time and grows the table as it goes
+        if (!test)
+        {
+            HashTable<BulkLoader::Entry> table;
+
+            start = chrono::steady_clock::now();
+            loader.forEach([&table](BulkLoader::Entry &entry) { table.add(entry.getKey(), &entry); });
+            cout << "\tHashTable, growing add():\t" << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+            distinct = table.getSize();
+        }
+
+        {
+            HashTable<BulkLoader::Entry> table;
+
+            start = chrono::steady_clock::now();
+            loader.loadInto(table);
+            cout << "\tHashTable, presized:\t\t" << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+            if (table.getSize() != distinct)
+                cout << "Loaded sizes differ!" << endl;
+        }
+
+        {
+            ConcurrentHashTable<BulkLoader::Entry> table(loader.getPartitionCount());
+
+            start = chrono::steady_clock::now();
+            loader.loadInto(table);
+            cout << "\tConcurrentHashTable:\t\t" << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+            if (table.getSize() != distinct)
+                cout << "Loaded sizes differ!" << endl;
+        }
+    }
+
+    if (!path)
+        remove(file.c_str());
+
+    return result;
+}
+
+/**
+ *  @brief Runs LRUCaches of several capacities in front of a store of definitions, over a Zipf
+ *  distributed stream of requests, and prints their counters and the time per request.
+ */
+static void runCacheBenchmark(void)
+{
+    static const double capacityPercents[] = { 0.1, 1, 5, 20 };
+
+    vector<string> words = makeWords(CACHE_KEY_COUNT, 20, "");
+    vector<string> store;
+    store.reserve(words.size());
+    for (size_t iteration = 0; iteration < words.size(); iteration++)
+        store.push_back("The meaning of " + words[iteration]);
+
+    // The word of rank r is requested in proportion to 1 / r^CACHE_SKEW
+    vector<double> cumulative(words.size());
+    double total = 0;
+    for (size_t rank = 0; rank < words.size(); rank++)
+        cumulative[rank] = total += 1 / pow(static_cast<double>(rank + 1), CACHE_SKEW);
+
+    mt19937_64 generator(21);
+    uniform_real_distribution<double> distribution(0, total);
+    vector<size_t> requests;
+    requests.reserve(CACHE_REQUEST_COUNT);
+    for (size_t iteration = 0; iteration < CACHE_REQUEST_COUNT; iteration++)
+    {
+        size_t rank = lower_bound(cumulative.begin(), cumulative.end(), distribution(generator)) - cumulative.begin();
+        requests.push_back(rank < words.size() ? rank : words.size() - 1);
+    }
+
+    cout << words.size() << " keys, " << requests.size() << " requests, Zipf exponent " << CACHE_SKEW << endl;
+    cout << "Capacity\tHits\tMisses\tEvictions\tHit rate\tns/request" << endl;
+
+    for (size_t test = 0; test < sizeof(capacityPercents) / sizeof(double); test++)
+    {
+        LRUCache<string> cache(static_cast<size_t>(words.size() * capacityPercents[test] / 100));
+
+        // Every miss reads the definition from the store and caches a copy of it
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t iteration = 0; iteration < requests.size(); iteration++)
+        {
+            const string &word = words[requests[iteration]];
+            if (!cache.find(word))
+                cache.emplace(word, store[requests[iteration]]);
+        }
+
+        double nanoseconds = elapsedNanoseconds(start) / requests.size();
+        LRUCache<string>::Statistics statistics = cache.getStatistics();
+
+        cout << statistics.capacity << " (" << capacityPercents[test] << "%)\t" << statistics.hits << "\t"
+             << statistics.misses << "\t" << statistics.evictions << "\t\t" << statistics.hitRate * 100 << "%\t\t"
+             << nanoseconds << endl;
+    }
+}
+
+/**
+ *  @brief Compares lookup latency of a plain HashTable against FilteredHashTable at several false
+ *  positive rates, when most lookups are for absent keys.
+ */
+static void runBloomBenchmark(void)
+{
+    static const double falsePositiveRates[] = { 0.1, 0.01, 0.001 };
+
+    vector<string> words = makeWords(BLOOM_KEY_COUNT, 8, "");
+    vector<string> absent = makeWords(LOOKUP_COUNT, 9, "_");
+    int value = 0;
+
+    // The mixed workload interleaves hits and misses so that neither stays warm in the caches
+    mt19937_64 generator(10);
+    vector<string> mixed;
+    mixed.reserve(LOOKUP_COUNT);
+    for (size_t iteration = 0; iteration < LOOKUP_COUNT; iteration++)
+    {
+        if (iteration * 100 < static_cast<size_t>(LOOKUP_COUNT) * BLOOM_MISS_PERCENT)
+            mixed.push_back(absent[iteration]);
+        else
+            mixed.push_back(words[generator() % words.size()]);
+    }
+    shuffle(mixed.begin(), mixed.end(), generator);
+
+    cout << words.size() << " keys, " << BLOOM_MISS_PERCENT << "% of mixed lookups miss" << endl;
+    cout << "Table\t\t\tMiss ns\tMixed ns\tFalse positives\tFilter MiB" << endl;
+
+    {
+        HashTable<int> table(words.size() * 8 / 7 + 1);
+        for (size_t iteration = 0; iteration < words.size(); iteration++)
+            table.add(words[iteration], &value);
+
+        size_t found;
+        double miss = timeLookups(table, absent, found);
+        double all = timeLookups(table, mixed, found);
+
+        cout << "HashTable\t\t" << miss << "\t" << all << "\t\t-\t\t-" << endl;
+    }
+
+    for (size_t test = 0; test < sizeof(falsePositiveRates) / sizeof(double); test++)
+    {
+        FilteredHashTable<int> table(words.size(), falsePositiveRates[test]);
+        for (size_t iteration = 0; iteration < words.size(); iteration++)
+            table.add(words[iteration], &value);
+
+        size_t found;
+        double miss = timeLookups(table, absent, found);
+        double all = timeLookups(table, mixed, found);
+
+        // Every absent key the filter lets through is a false positive
+        size_t falsePositives = 0;
+        for (size_t iteration = 0; iteration < absent.size(); iteration++)
+            if (table.getFilter().mayContain(FNV1aHasher::hash(absent[iteration].data(), absent[iteration].size())))
+                ++falsePositives;
+
+        cout << "Filtered, " << falsePositiveRates[test] * 100 << "%\t\t" << miss << "\t" << all << "\t\t"
+             << 100.0 * falsePositives / absent.size() << "%\t\t"
+             << table.getFilter().getByteSize() / static_cast<double>(1 << 20) << endl;
+    }
+}
+
+/**
+ *  @brief Times FuzzyIndex searches for misspelled words against comparing the query with every
+ *  key.
+ */
+static void runFuzzyBenchmark(void)
+{
+    vector<string> words = makeWords(FUZZY_KEY_COUNT, 11, "");
+    mt19937_64 generator(12);
+
+    // Each query is a key with one or two random insertions, deletions or substitutions
+    vector<string> queries;
+    queries.reserve(FUZZY_QUERY_COUNT);
+    for (size_t iteration = 0; iteration < FUZZY_QUERY_COUNT; iteration++)
+    {
+        string query = words[generator() % words.size()];
+
+        for (size_t edits = 1 + generator() % 2; edits; edits--)
+        {
+            size_t position = generator() % (query.size() + 1);
+            char letter = static_cast<char>('a' + generator() % 26);
+
+            switch (generator() % 3)
+            {
+                case 0:
+                    query.insert(position, 1, letter);
+                    break;
+
+                case 1:
+                    if (position < query.size())
+                        query.erase(position, 1);
+                    break;
+
+                default:
+                    if (position < query.size())
+                        query[position] = letter;
+            }
+        }
+
+        queries.push_back(query);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    FuzzyIndex index(2);
+    for (size_t iteration = 0; iteration < words.size(); iteration++)
+        index.add(words[iteration]);
+    index.build();
+
+    cout << "Indexed " << words.size() << " keys in " << elapsedNanoseconds(start) / 1e6 << " ms, "
+         << index.getByteSize() / static_cast<double>(1 << 20) << " MiB" << endl;
+
+    for (uint32_t distance = 1; distance <= index.getMaxDistance(); distance++)
+    {
+        size_t matches = 0;
+
+        start = chrono::steady_clock::now();
+        for (size_t iteration = 0; iteration < queries.size(); iteration++)
+            matches += index.search(queries[iteration], distance).size();
+
+        cout << "Distance " << distance << ": FuzzyIndex " << elapsedNanoseconds(start) / queries.size() / 1e3
+             << " us/query, " << static_cast<double>(matches) / queries.size() << " matches/query" << endl;
+
+        size_t scanned = 0;
+
+        start = chrono::steady_clock::now();
+        for (size_t iteration = 0; iteration < FUZZY_SCAN_COUNT; iteration++)
+        {
+            EditDistanceMatcher matcher(queries[iteration]);
+
+            for (size_t word = 0; word < words.size(); word++)
+                if (matcher.measure(words[word], distance) <= distance)
+                    ++scanned;
+        }
+
+        double scan = elapsedNanoseconds(start) / FUZZY_SCAN_COUNT / 1e3;
+
+        // The index must agree with the scan on the queries both answered
+        size_t indexed = 0;
+        for (size_t iteration = 0; iteration < FUZZY_SCAN_COUNT; iteration++)
+            indexed += index.search(queries[iteration], distance).size();
+
+        cout << "\tScanning every key: " << scan << " us/query" << (indexed == scanned ? "" : " (results differ!)") << endl;
+    }
+}
+
+/**
+ *  @brief Compares calling find() once per key against findBatch() for batches of 1 to
+ *  MAX_BATCH_SIZE keys, on a table far larger than the processor caches.
+ */
+static void runBatchBenchmark(void)
+{
+    vector<string> words = makeWords(BATCH_KEY_COUNT, 13, "");
+
+    HashTable<int> table(words.size() * 8 / 7 + 1);
+    int value = 0;
+    for (size_t iteration = 0; iteration < words.size(); iteration++)
+        table.add(words[iteration], &value);
+
+    // Random keys, so that every lookup misses the caches. They are copied next to each other, as
+    // a request would hold them, so that reading the keys themselves does not miss as well.
+    mt19937_64 generator(14);
+    vector<string> queries;
+    queries.reserve(LOOKUP_COUNT);
+    for (size_t iteration = 0; iteration < LOOKUP_COUNT; iteration++)
+        queries.push_back(words[generator() % words.size()]);
+
+    vector<string_view> keys(queries.begin(), queries.end());
+
+    vector<int *> results(MAX_BATCH_SIZE);
+    size_t found = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < keys.size(); iteration++)
+        if (table.find(keys[iteration]))
+            ++found;
+
+    double serial = elapsedNanoseconds(start) / keys.size();
+
+    cout << words.size() << " keys, " << table.getCapacity() << " Buckets" << endl;
+    cout << "One find() per key:\t" << serial << " ns/key" << (found == keys.size() ? "" : " (lookups failed!)") << endl;
+    cout << "Batch\tns/key\tSpeedup" << endl;
+
+    for (size_t batch = 1; batch <= MAX_BATCH_SIZE; batch *= 2)
+    {
+        found = 0;
+
+        start = chrono::steady_clock::now();
+        for (size_t first = 0; first + batch <= keys.size(); first += batch)
+            found += table.findBatch(&keys[first], batch, results.data());
+
+        size_t looked = keys.size() / batch * batch;
+        double batched = elapsedNanoseconds(start) / looked;
+
+        cout << batch << "\t" << batched << "\t" << serial / batched << (found == looked ? "" : " (lookups failed!)") << endl;
+    }
+}
+
+/**
+ *  @brief Compares adds and lookups of PersistentHashTable against HashTable, and measures how
+ *  adds fare while another thread keeps writing snapshots of the table into a stream, which a
+ *  HashTable could only do by stopping its writer for a whole dump.
+ */
+static void runSnapshotBenchmark(void)
+{
+    vector<string> words = makeWords(SNAPSHOT_KEY_COUNT, 16, "");
+    int value = 0;
+    size_t found;
+
+    cout << words.size() << " keys" << endl;
+    cout << "Table\t\t\tns/add\tns/find\tDump ms" << endl;
+
+    {
+        HashTable<int> table;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t iteration = 0; iteration < words.size(); iteration++)
+            table.add(words[iteration], &value);
+
+        double add = elapsedNanoseconds(start) / words.size();
+        double find = timeLookups(table, words, found);
+
+        ostringstream dump;
+        start = chrono::steady_clock::now();
+        dump << table;
+
+        cout << "HashTable\t\t" << add << "\t" << find << "\t" << elapsedNanoseconds(start) / 1e6 << endl;
+    }
+
+    PersistentHashTable<int> table;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < words.size(); iteration++)
+        table.add(words[iteration], &value);
+
+    double add = elapsedNanoseconds(start) / words.size();
+    double find = timeLookups(table, words, found);
+
+    ostringstream dump;
+    start = chrono::steady_clock::now();
+    dump << table;
+
+    cout << "PersistentHashTable\t" << add << "\t" << find << "\t" << elapsedNanoseconds(start) / 1e6
+         << (found == words.size() ? "" : " (lookups failed!)") << endl;
+
+    // A snapshot is one reference count, and the first change after it copies one path
+    start = chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < LOOKUP_COUNT; iteration++)
+        PersistentHashTable<int>::Snapshot snapshot = table.snapshot();
+
+    double snapshot = elapsedNanoseconds(start) / LOOKUP_COUNT;
+
+    start = chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < words.size(); iteration++)
+    {
+        PersistentHashTable<int>::Snapshot frozen = table.snapshot();
+        table.add(words[iteration], &value);
+    }
+
+    cout << "snapshot(): " << snapshot << " ns, add() right after a snapshot: "
+         << elapsedNanoseconds(start) / words.size() << " ns" << endl;
+
+    // The writer starts over while a second thread dumps the latest snapshot it was handed
+    table.clear();
+
+    mutex lock;
+    PersistentHashTable<int>::Snapshot *latest = NULL;
+    bool finished = false;
+    size_t dumps = 0;
+    bool consistent = true;
+
+    thread dumper([&]()
+    {
+        while (true)
+        {
+            PersistentHashTable<int>::Snapshot *snapshot;
+            {
+                lock_guard<mutex> guard(lock);
+                if (!latest && finished)
+                    break;
+
+                snapshot = latest;
+                latest = NULL;
+            }
+
+            if (!snapshot)
+            {
+                this_thread::yield();
+                continue;
+            }
+
+            ostringstream output;
+            output << *snapshot;
+
+            string text = output.str();
+            if (!snapshot->isEmpty() && static_cast<size_t>(count(text.begin(), text.end(), '\n')) + 1 != snapshot->getSize())
+                consistent = false;
+
+            delete snapshot;
+            ++dumps;
+        }
+    });
+
+    start = chrono::steady_clock::now();
+    double cpuStart = threadCpuNanoseconds();
+    for (size_t iteration = 0; iteration < words.size(); iteration++)
+    {
+        table.add(words[iteration], &value);
+
+        if ((iteration + 1) % SNAPSHOT_INTERVAL == 0)
+        {
+            PersistentHashTable<int>::Snapshot *snapshot = new PersistentHashTable<int>::Snapshot(table.snapshot());
+
+            lock_guard<mutex> guard(lock);
+            delete latest;
+            latest = snapshot;
+        }
+    }
+
+    add = elapsedNanoseconds(start) / words.size();
+    double addCpu = (threadCpuNanoseconds() - cpuStart) / words.size();
+
+    {
+        lock_guard<mutex> guard(lock);
+        finished = true;
+    }
+    dumper.join();
+
+    // With fewer cores than threads the wall clock also counts the time spent dumping
+    cout << "add() while dumping every " << SNAPSHOT_INTERVAL << " adds: " << add << " ns, " << addCpu
+         << " ns of it in the writer, " << dumps << " dumps written" << (consistent ? "" : " (a dump was torn!)") << endl;
+}
+
+/**
+ *  @brief Measures how many commits a WriteAheadLog shares per sync as threads are added, then
+ *  the cost of adds to a DurableHashTable, of a checkpoint, and of opening it from its log and
+ *  from its snapshot.
+ */
+static void runDurableBenchmark(void)
+{
+    static const size_t threadCounts[] = { 1, 2, 4, 8, 16 };
+
+    string base = DURABLE_FILE;
+    string log = base + ".log";
+    string snapshot = base + ".snapshot";
+
+    cout << "Threads\tCommits/s\tCommits/sync" << endl;
+
+    for (size_t test = 0; test < sizeof(threadCounts) / sizeof(size_t); test++)
+    {
+        remove(log.c_str());
+
+        WriteAheadLog wal;
+        if (!wal.open(log, [](string_view, string_view) { }))
+        {
+            cout << "Could not open " << log << endl;
+            return;
+        }
+
+        size_t threadCount = threadCounts[test];
+        vector<thread> threads;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t index = 0; index < threadCount; index++)
+        {
+            threads.push_back(thread([&wal, threadCount]()
+            {
+                uint64_t sequence;
+
+                for (size_t iteration = 0; iteration < DURABLE_COMMIT_COUNT / threadCount; iteration++)
+                    if (wal.append("word", "a definition of about this length", sequence))
+                        wal.commit(sequence);
+            }));
+        }
+
+        for (size_t index = 0; index < threads.size(); index++)
+            threads[index].join();
+
+        double seconds = elapsedNanoseconds(start) / 1e9;
+        size_t commits = DURABLE_COMMIT_COUNT / threadCount * threadCount;
+
+        cout << threadCount << "\t" << commits / seconds << "\t\t"
+             << static_cast<double>(commits) / wal.getSyncCount() << endl;
+    }
+
+    remove(log.c_str());
+
+    vector<string> words = makeWords(DURABLE_KEY_COUNT, 17, "");
+
+    {
+        // Large enough that no checkpoint is written while adding
+        DurableHashTable table(UINT64_MAX);
+        if (!table.open(base))
+        {
+            cout << "Could not open " << base << endl;
+            return;
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t iteration = 0; iteration < words.size(); iteration++)
+        {
+            table.add(words[iteration], words[iteration]);
+
+            if ((iteration + 1) % DURABLE_BATCH_SIZE == 0)
+                table.commit();
+        }
+        table.commit();
+
+        cout << words.size() << " adds, a commit every " << DURABLE_BATCH_SIZE << ": "
+             << elapsedNanoseconds(start) / words.size() << " ns/add" << endl;
+    }
+
+    {
+        DurableHashTable table;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        table.open(base);
+        cout << "Opening with " << table.getSize() << " words in the log: " << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+        // Rewriting everything is what each commit would cost without the log
+        start = chrono::steady_clock::now();
+        bool written = table.checkpoint();
+        cout << "Checkpoint: " << elapsedNanoseconds(start) / 1e6 << " ms" << (written ? "" : " (failed!)") << endl;
+    }
+
+    {
+        DurableHashTable table;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        table.open(base);
+
+        double elapsed = elapsedNanoseconds(start);
+        string_view value;
+        bool intact = table.getSize() == words.size() && table.find(words.back(), value) && value == words.back();
+
+        cout << "Opening with " << table.getSize() << " words in the snapshot: " << elapsed / 1e6 << " ms"
+             << (intact ? "" : " (words lost!)") << endl;
+    }
+
+    remove(log.c_str());
+    remove(snapshot.c_str());
+}
+
+/**
+ *  @brief Main entry point of the program.
+ *  @param argc The number of arguments that can be
+ *  found in argv.
+ *  @param argv The space-delineated parameter list passed
+ *  in the operating system. The first argument names the benchmark to run.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cout << "Usage: " << argv[0] << " <benchmark>" << endl;
+        cout << "Benchmarks:" << endl;
+        cout << "\tprobe\tHit and miss lookups of HashTable and SwissHashTable by load factor" << endl;
+        cout << "\tgrowth\tPer insert latency of HashTable while it grows" << endl;
+        cout << "\tconcurrent\tThread safe table throughput by thread count and read/write mix" << endl;
+        cout << "\tintern\tAdd and lookup time and heap of HashTable against InternedHashTable, and a dump of the key arena" << endl;
+        cout << "\thash [file]\tHasher throughput, collisions and probe lengths for the keys in file, one per line" << endl;
+        cout << "\tbulk [file]\tParallel load of a tab separated dictionary file against growing add()" << endl;
+        cout << "\tcache\tHits, misses, evictions and time per request of LRUCaches of several sizes over skewed requests" << endl;
+        cout << "\tbloom\tMiss and mixed lookup latency of HashTable with and without a Bloom filter" << endl;
+        cout << "\tfuzzy\tFuzzyIndex search for misspelled words against scanning every key" << endl;
+        cout << "\tbatch\tfindBatch() throughput by batch size against one find() per key" << endl;
+        cout << "\tsnapshot\tPersistentHashTable adds, lookups and snapshots, alone and while another thread dumps it" << endl;
+        cout << "\tdurable\tWriteAheadLog group commit by thread count, and DurableHashTable adds, checkpoint and reopening" << endl;
+        return 1;
+    }
+
+    if (!strcmp(argv[1], "probe"))
+        runProbeBenchmark();
+    else if (!strcmp(argv[1], "growth"))
+        runGrowthBenchmark();
+    else if (!strcmp(argv[1], "concurrent"))
+        runConcurrentBenchmark();
+    else if (!strcmp(argv[1], "intern"))
+        runInternBenchmark();
+    else if (!strcmp(argv[1], "hash"))
+    {
+        if (!runHashBenchmark(argc > 2 ? argv[2] : NULL))
+            return 1;
+    }
+    else if (!strcmp(argv[1], "bulk"))
+    {
+        if (!runBulkBenchmark(argc > 2 ? argv[2] : NULL))
+            return 1;
+    }
+    else if (!strcmp(argv[1], "cache"))
+        runCacheBenchmark();
+    else if (!strcmp(argv[1], "bloom"))
+        runBloomBenchmark();
+    else if (!strcmp(argv[1], "fuzzy"))
+        runFuzzyBenchmark();
+    else if (!strcmp(argv[1], "batch"))
+        runBatchBenchmark();
+    else if (!strcmp(argv[1], "snapshot"))
+        runSnapshotBenchmark();
+    else if (!strcmp(argv[1], "durable"))
+        runDurableBenchmark();
+    else
+    {
+        cout << "Unknown benchmark: " << argv[1] << endl;
+        return 1;
+    }
+
+    return 0;
+}